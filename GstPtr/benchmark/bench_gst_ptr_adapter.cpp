@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+#include <gst/gst.h>
+
+#include "../gst_ptr_adapter.h"
+
+#include <cstring>
+#include <vector>
+
+// MPEG-TS style ingest: chunks of 7 packets arrive with a random-ish split,
+// and 188 bytes packets are extracted after reading their 4 bytes header, as
+// a demuxer would. A std::vector<uint8_t> accumulator is compared against
+// GstByteAdapter, counting the bytes each one copies.
+
+namespace {
+
+constexpr std::size_t PACKET_SIZE = 188;
+constexpr std::size_t HEADER_SIZE = 4;
+constexpr std::size_t CHUNK_SIZE = 7 * PACKET_SIZE + 61;
+constexpr std::size_t CHUNKS = 256;
+
+std::vector<GstPtr<GstBuffer>> makeChunks() {
+  std::vector<GstPtr<GstBuffer>> chunks;
+  chunks.reserve(CHUNKS);
+  for (std::size_t chunk = 0; chunk < CHUNKS; ++chunk) {
+    GstPtr<GstBuffer> buffer =
+        gst_buffer_new_allocate(nullptr, CHUNK_SIZE, nullptr);
+    gst_buffer_memset(buffer.self(), 0, 0x47, CHUNK_SIZE);
+    chunks.push_back(std::move(buffer));
+  }
+  return chunks;
+}
+
+void vectorAccumulator(benchmark::State &state) {
+  const auto chunks = makeChunks();
+  std::uint64_t bytesCopied = 0;
+  for (auto _ : state) {
+    std::vector<std::uint8_t> pending;
+    for (const auto &chunk : chunks) {
+      GstMapInfo map;
+      gst_buffer_map(chunk.self(), &map, GST_MAP_READ);
+      pending.insert(pending.end(), map.data, map.data + map.size);
+      bytesCopied += map.size;
+      gst_buffer_unmap(chunk.self(), &map);
+
+      std::size_t consumed = 0;
+      while (pending.size() - consumed >= PACKET_SIZE) {
+        benchmark::DoNotOptimize(pending[consumed + HEADER_SIZE - 1]);
+        GstPtr<GstBuffer> packet =
+            gst_buffer_new_memdup(pending.data() + consumed, PACKET_SIZE);
+        bytesCopied += PACKET_SIZE;
+        benchmark::DoNotOptimize(packet.self());
+        consumed += PACKET_SIZE;
+      }
+      bytesCopied += pending.size() - consumed;
+      pending.erase(pending.begin(),
+                    pending.begin() + static_cast<std::ptrdiff_t>(consumed));
+    }
+  }
+  state.counters["bytesCopied/iter"] = benchmark::Counter(
+      static_cast<double>(bytesCopied), benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * CHUNKS *
+                                               CHUNK_SIZE));
+}
+BENCHMARK(vectorAccumulator);
+
+void byteAdapter(benchmark::State &state) {
+  const auto chunks = makeChunks();
+  std::uint64_t bytesCopied = 0;
+  for (auto _ : state) {
+    GstByteAdapter adapter;
+    for (const auto &chunk : chunks) {
+      GstPtr<GstBuffer> toPush = chunk;
+      adapter.push(std::move(toPush));
+      while (adapter.available() >= PACKET_SIZE) {
+        {
+          // Copied only when the header spans two chunks
+          auto header = adapter.peek(HEADER_SIZE);
+          benchmark::DoNotOptimize((*header)[HEADER_SIZE - 1]);
+        }
+        GstPtr<GstBuffer> packet = adapter.takeBuffer(PACKET_SIZE);
+        benchmark::DoNotOptimize(packet.self());
+      }
+    }
+    bytesCopied += adapter.stats().bytesCopied;
+  }
+  state.counters["bytesCopied/iter"] = benchmark::Counter(
+      static_cast<double>(bytesCopied), benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * CHUNKS *
+                                               CHUNK_SIZE));
+}
+BENCHMARK(byteAdapter);
+
+void startCodeScan(benchmark::State &state) {
+  // A NAL unit start code at the very end of the stream
+  std::vector<std::uint8_t> data(CHUNKS * CHUNK_SIZE, 0xAA);
+  data[data.size() - 5] = 0x00;
+  data[data.size() - 4] = 0x00;
+  data[data.size() - 3] = 0x01;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(findStartCode(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(startCodeScan);
+
+} // namespace
+
+int main(int argc, char **argv) {
+  gst_init(&argc, &argv);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
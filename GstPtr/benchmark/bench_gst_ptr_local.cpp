@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include <gst/gst.h>
+
+#include "../gst_ptr_local.h"
+
+// Threads sharing one GstCaps/GstElement: copying the GstPtr for every
+// operation (a ref and an unref on the shared refcount) is compared against
+// a GstLocalRef per thread, as the number of threads grows.
+// bench_gst_ptr_local_dummy does the same without GStreamer's refcounting.
+
+namespace {
+
+template <typename Type> GstPtr<Type> makeObject();
+
+template <> GstPtr<GstCaps> makeObject<GstCaps>() {
+  return gst_caps_from_string("video/x-raw, format=(string)NV12, "
+                              "width=(int)1920, height=(int)1080");
+}
+
+template <> GstPtr<GstElement> makeObject<GstElement>() {
+  GstPtr<GstElement> bin = gst_bin_new("shared");
+  bin.sink();
+  return bin;
+}
+
+template <typename Type> const GstPtr<Type> &sharedObject() {
+  static const GstPtr<Type> object = makeObject<Type>();
+  return object;
+}
+
+template <typename Type> const GstSharedRef<Type> &sharedRef() {
+  static const GstSharedRef<Type> shared{sharedObject<Type>()};
+  return shared;
+}
+
+template <typename Type> void copyPerOperation(benchmark::State &state) {
+  const GstPtr<Type> &shared = sharedObject<Type>();
+  for (auto _ : state) {
+    GstPtr<Type> copy = shared;
+    benchmark::DoNotOptimize(copy.self());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Type> void localRef(benchmark::State &state) {
+  GstLocalRef<Type> local{sharedRef<Type>()};
+  for (auto _ : state) {
+    GstPtrView<Type> view = local.get();
+    benchmark::DoNotOptimize(view.self());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+constexpr int MAX_THREADS = 32;
+
+BENCHMARK_TEMPLATE(copyPerOperation, GstCaps)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(localRef, GstCaps)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+BENCHMARK_TEMPLATE(copyPerOperation, GstElement)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(localRef, GstElement)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+
+} // namespace
+
+int main(int argc, char **argv) {
+  gst_init(&argc, &argv);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
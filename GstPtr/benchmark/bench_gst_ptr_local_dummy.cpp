@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+// The dummy glib/gstreamer of the tests isolates the cost of the shared
+// refcount from GStreamer's own checks.
+#include "../test/gst_ptr_dummy.h"
+
+#include "../gst_ptr_local.h"
+
+namespace {
+
+// Shared by all the threads of a benchmark
+template <typename Type> const GstPtr<Type> &sharedObject() {
+  static const GstPtr<Type> object = new Type();
+  return object;
+}
+
+template <typename Type> const GstSharedRef<Type> &sharedRef() {
+  static const GstSharedRef<Type> shared{sharedObject<Type>()};
+  return shared;
+}
+
+template <typename Type> void copyPerOperation(benchmark::State &state) {
+  const GstPtr<Type> &shared = sharedObject<Type>();
+  for (auto _ : state) {
+    GstPtr<Type> copy = shared;
+    benchmark::DoNotOptimize(copy.self());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Type> void localRef(benchmark::State &state) {
+  const GstSharedRef<Type> &shared = sharedRef<Type>();
+  GstLocalRef<Type> local{shared};
+  for (auto _ : state) {
+    GstPtrView<Type> view = local.get();
+    benchmark::DoNotOptimize(view.self());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+constexpr int MAX_THREADS = 32;
+
+BENCHMARK_TEMPLATE(copyPerOperation, GstCaps)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(localRef, GstCaps)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+BENCHMARK_TEMPLATE(copyPerOperation, GstElement)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(localRef, GstElement)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include <gst/gst.h>
+
+#include "../gst_ptr_structure.h"
+
+// Compares string-keyed GstStructure reads against GstField<> descriptors,
+// on caps similar to the ones negotiated for raw video.
+
+namespace {
+
+constexpr const char *CAPS_DESCRIPTION =
+    "video/x-raw, format=(string)NV12, width=(int)1920, height=(int)1080, "
+    "interlace-mode=(string)progressive, multiview-mode=(string)mono, "
+    "pixel-aspect-ratio=(fraction)1/1, chroma-site=(string)mpeg2, "
+    "colorimetry=(string)bt709, framerate=(fraction)30/1";
+
+inline const GstField<gint> widthField{"width"};
+inline const GstField<gint> heightField{"height"};
+inline const GstField<GstFieldFraction> framerateField{"framerate"};
+inline const GstField<const gchar *> formatField{"format"};
+
+GstPtr<GstCaps> makeCaps() {
+  return gst_caps_from_string(CAPS_DESCRIPTION);
+}
+
+void stringKeyed(benchmark::State &state) {
+  auto caps = makeCaps();
+  const GstStructure *structure = borrowStructure(caps);
+  for (auto _ : state) {
+    gint width = 0;
+    gint height = 0;
+    gint fpsNum = 0;
+    gint fpsDen = 0;
+    gst_structure_get_int(structure, "width", &width);
+    gst_structure_get_int(structure, "height", &height);
+    gst_structure_get_fraction(structure, "framerate", &fpsNum, &fpsDen);
+    const gchar *format = gst_structure_get_string(structure, "format");
+    benchmark::DoNotOptimize(width + height + fpsNum + fpsDen);
+    benchmark::DoNotOptimize(format);
+  }
+}
+BENCHMARK(stringKeyed);
+
+void quarkCachedFields(benchmark::State &state) {
+  auto caps = makeCaps();
+  const GstStructure *structure = borrowStructure(caps);
+  for (auto _ : state) {
+    auto width = widthField.get(structure);
+    auto height = heightField.get(structure);
+    auto framerate = framerateField.get(structure);
+    auto format = formatField.get(structure);
+    benchmark::DoNotOptimize(width);
+    benchmark::DoNotOptimize(height);
+    benchmark::DoNotOptimize(framerate);
+    benchmark::DoNotOptimize(format);
+  }
+}
+BENCHMARK(quarkCachedFields);
+
+void quarkCachedSinglePass(benchmark::State &state) {
+  auto caps = makeCaps();
+  const GstStructure *structure = borrowStructure(caps);
+  for (auto _ : state) {
+    auto fields = readFields(structure, widthField, heightField,
+                             framerateField, formatField);
+    benchmark::DoNotOptimize(fields);
+  }
+}
+BENCHMARK(quarkCachedSinglePass);
+
+} // namespace
+
+int main(int argc, char **argv) {
+  gst_init(&argc, &argv);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
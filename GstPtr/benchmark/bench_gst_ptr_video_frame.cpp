@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+#include <gst/gst.h>
+
+#include "../gst_ptr_video_frame.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BENCH_HAS_SSE2 1
+#endif
+
+// A brightness kernel on the planes of an I420 frame, as an example of using
+// GstPlaneView alignment/padding information to skip the scalar tail.
+
+namespace {
+
+constexpr guint8 BRIGHTNESS = 16;
+
+void brightenScalar(const GstPlaneView<const guint8> &input,
+                    const GstPlaneView<guint8> &output) {
+  for (guint y = 0; y < input.height(); ++y) {
+    const guint8 *source = input.row(y);
+    guint8 *destination = output.row(y);
+    for (guint x = 0; x < input.width(); ++x) {
+      destination[x] = static_cast<guint8>(
+          std::min<guint>(255U, static_cast<guint>(source[x]) + BRIGHTNESS));
+    }
+  }
+}
+
+#ifdef BENCH_HAS_SSE2
+void brightenSse2(const GstPlaneView<const guint8> &input,
+                  const GstPlaneView<guint8> &output) {
+  constexpr guint VECTOR = 16;
+  const __m128i offset = _mm_set1_epi8(static_cast<char>(BRIGHTNESS));
+  const bool aligned =
+      input.isVectorFriendly(VECTOR) && output.isVectorFriendly(VECTOR);
+  const guint paddedColumns =
+      std::min(input.paddedWidth(), output.paddedWidth());
+  const guint vectorColumns = input.width() / VECTOR * VECTOR;
+
+  for (guint y = 0; y < input.height(); ++y) {
+    const guint8 *source = input.row(y);
+    guint8 *destination = output.row(y);
+    // Aligned rows are processed up to the padding, without a scalar tail,
+    // but the last one: the plane may end at its width
+    const guint columns =
+        aligned && y < input.paddedRows() ? paddedColumns : vectorColumns;
+    guint x = 0;
+    if (aligned) {
+      for (; x < columns; x += VECTOR) {
+        const __m128i pixels =
+            _mm_load_si128(reinterpret_cast<const __m128i *>(source + x));
+        _mm_store_si128(reinterpret_cast<__m128i *>(destination + x),
+                        _mm_adds_epu8(pixels, offset));
+      }
+    } else {
+      for (; x < columns; x += VECTOR) {
+        const __m128i pixels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + x),
+                         _mm_adds_epu8(pixels, offset));
+      }
+    }
+    for (; x < input.width(); ++x) {
+      destination[x] = static_cast<guint8>(
+          std::min<guint>(255U, static_cast<guint>(source[x]) + BRIGHTNESS));
+    }
+  }
+}
+#endif
+
+template <typename Kernel>
+void runKernel(benchmark::State &state, Kernel kernel) {
+  GstVideoInfo info;
+  gst_video_info_set_format(&info, GST_VIDEO_FORMAT_I420, 1920, 1080);
+  GstPtr<GstBuffer> input =
+      gst_buffer_new_allocate(nullptr, GST_VIDEO_INFO_SIZE(&info), nullptr);
+  GstPtr<GstBuffer> output =
+      gst_buffer_new_allocate(nullptr, GST_VIDEO_INFO_SIZE(&info), nullptr);
+
+  for (auto _ : state) {
+    GstMappedVideoTransform transform{input, info, output, info};
+    for (guint plane = 0; plane < transform.input().planes(); ++plane) {
+      kernel(transform.input().plane<const guint8>(plane),
+             transform.output().plane<guint8>(plane));
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(GST_VIDEO_INFO_SIZE(&info)));
+}
+
+void scalarKernel(benchmark::State &state) { runKernel(state, brightenScalar); }
+BENCHMARK(scalarKernel);
+
+#ifdef BENCH_HAS_SSE2
+void sse2Kernel(benchmark::State &state) { runKernel(state, brightenSse2); }
+BENCHMARK(sse2Kernel);
+#endif
+
+} // namespace
+
+int main(int argc, char **argv) {
+  gst_init(&argc, &argv);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
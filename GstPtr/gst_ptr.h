@@ -170,6 +170,18 @@ Always:
  * Static cast is checked at build-time.
  * Dynamic cast use GLib's functions for casting, but it will throw std::bad_cast
  if the cast can't be done. GLib's function instead, issues a warning.
+
+5. Views
+--------
+
+GstPtrView<Type> is a raw pointer that someone else keeps alive (i.e. the
+element yielded by an iterator). It never touches the refcount, and it has the
+same self()/self<BaseType>() as GstPtr. If you need to keep the object, take
+a reference with owned():
+
+ GstPtrView<GstElement> view = ...;
+ gst_element_set_state(view.self(), GST_STATE_PLAYING);
+ GstPtr<GstElement> kept = view.owned();   // [transfer::none] semantics
 */
 
 #pragma once
@@ -364,7 +376,10 @@ public:
   }
 
   GstPtr &operator=(GstPtr &&other) noexcept {
-    moveReference(std::move(other));
+    if (this != &other) {
+      reset(nullptr);
+      moveReference(std::move(other));
+    }
     return *this;
   }
 
@@ -493,3 +508,69 @@ template <typename Derived, typename Base>
   derived.transferNone(base.template selfDynamic<Derived>());
   return derived;
 }
+
+/// Non-owning view of a GStreamer/Glib object, kept alive by someone else
+/// @tparam Type is a GStreamer/GLib object
+template <typename Type> class GstPtrView {
+
+  static_assert(detail::IsInterfaceImplemented<Type>::value,
+                "So sorry! There's no interface defined for this type. "
+                "You need add it into GstPtr<> source code or extend "
+                "this header");
+
+public:
+  GstPtrView() noexcept = default;
+  GstPtrView(Type *borrowed) noexcept : m_pointer(borrowed) {}
+  GstPtrView(const GstPtr<Type> &owner) noexcept : m_pointer(owner.self()) {}
+
+  /// Views a derived object as its base \p Type (i.e. a GstPipeline as a
+  /// GstElement). Checked at build-time, like self<BaseType>().
+  template <typename Derived,
+            typename = std::enable_if_t<std::is_base_of_v<
+                typename detail::GetInterface<Type>::type,
+                typename detail::GetInterface<Derived>::type>>>
+  GstPtrView(const GstPtr<Derived> &owner) noexcept
+      : m_pointer((Type *)owner.self()) {}
+
+  template <typename Derived,
+            typename = std::enable_if_t<std::is_base_of_v<
+                typename detail::GetInterface<Type>::type,
+                typename detail::GetInterface<Derived>::type>>>
+  GstPtrView(const GstPtrView<Derived> &other) noexcept
+      : m_pointer((Type *)other.self()) {}
+
+  /// Takes a new reference to the viewed object
+  [[nodiscard]] GstPtr<Type> owned() const noexcept {
+    GstPtr<Type> owner;
+    owner.transferNone(m_pointer);
+    return owner;
+  }
+
+  /// @return The raw pointer
+  [[nodiscard]] Type *self() const noexcept { return m_pointer; }
+
+  /// @return The raw pointer casted to \p toBaseType*
+  /// @note Only casting to a base class is allowed.
+  template <typename toBaseType> [[nodiscard]] toBaseType *self() const noexcept {
+    using BaseInterface = typename detail::GetInterface<toBaseType>::type;
+    using DerivedInterface = typename detail::GetInterface<Type>::type;
+    static_assert(std::is_base_of_v<BaseInterface, DerivedInterface>,
+                  "For static casting, you can only cast to base objects.");
+    return (toBaseType *)m_pointer;
+  }
+
+  Type *operator->() const noexcept { return m_pointer; }
+
+  /// Returns true if the view is not nullptr
+  explicit operator bool() const noexcept { return m_pointer != nullptr; }
+
+  bool operator==(const GstPtrView &other) const noexcept {
+    return m_pointer == other.m_pointer;
+  }
+  bool operator!=(const GstPtrView &other) const noexcept {
+    return m_pointer != other.m_pointer;
+  }
+
+private:
+  Type *m_pointer = nullptr;
+};
@@ -0,0 +1,291 @@
+/*
+ *  GstByteAdapter assembles a byte stream out of GstBuffers without copying.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17 and gst-base (gstreamer-base-1.0)
+ *
+ */
+
+/*
+A parser that receives a stream in arbitrary chunks usually appends them to a
+std::vector<uint8_t>, and then copies each complete unit out again.
+GstAdapter keeps the chunks as they are; GstByteAdapter wraps it:
+
+ GstByteAdapter adapter;
+ adapter.push(std::move(buffer));                 // takes our ref, no copy
+
+ auto start = adapter.maskedScan(START_CODE_MASK, START_CODE_PATTERN);
+ if (auto header = adapter.peekContiguous(4)) {   // span, only if no copy
+   ... header->data() ...
+ }
+ GstPtr<GstBuffer> unit = adapter.takeBuffer(n);  // sub-buffers, no memcpy
+
+- peekContiguous() only succeeds when the bytes are in the first chunk;
+  peek() always succeeds (if there are enough bytes), copying when they span
+  several chunks. The number of bytes copied is kept in stats().
+- timestampAt() tells the PTS/DTS/offset of the chunk a byte came from, and
+  its distance from the start of that chunk.
+- maskedScan() uses the vectorized scan of gst_ptr_byte_scan.h over the first
+  chunk, and gst_adapter_masked_scan_uint32_peek() beyond it.
+- GstAdapter has a single mapping: mapping again drops the previous one. So
+  only one GstAdapterSpan can be alive at a time, and while it is, peeking,
+  scanning, taking or flushing throw std::logic_error. Pushing is allowed.
+
+GstAdapter is also mapped for GstPtr<GstAdapter>.
+
+This header is empty unless <gst/base/gstadapter.h> can be included.
+*/
+
+#pragma once
+
+#if __has_include(<gst/base/gstadapter.h>)
+#include <gst/base/gstadapter.h>
+
+#include "gst_ptr.h"
+#include "gst_ptr_byte_scan.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace detail {
+struct IGstAdapter : IGObject {};
+GST_PTR_MAP_INTERFACE_WITH_TYPE(GstAdapter, GST_TYPE_ADAPTER)
+} // namespace detail
+
+class GstByteAdapter;
+
+/// Bytes peeked from a GstByteAdapter. They are valid while this object
+/// exists; it is the only mapping of the adapter meanwhile.
+class GstAdapterSpan {
+public:
+  GstAdapterSpan(GstAdapterSpan &&other) noexcept
+      : m_adapter(other.m_adapter), m_data(other.m_data), m_size(other.m_size) {
+    other.m_adapter = nullptr;
+  }
+  GstAdapterSpan &operator=(GstAdapterSpan &&) = delete;
+  GstAdapterSpan(const GstAdapterSpan &) = delete;
+  GstAdapterSpan &operator=(const GstAdapterSpan &) = delete;
+
+  inline ~GstAdapterSpan();
+
+  [[nodiscard]] const std::uint8_t *data() const noexcept { return m_data; }
+  [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+  [[nodiscard]] const std::uint8_t *begin() const noexcept { return m_data; }
+  [[nodiscard]] const std::uint8_t *end() const noexcept {
+    return m_data + m_size;
+  }
+  std::uint8_t operator[](std::size_t index) const noexcept {
+    return m_data[index];
+  }
+
+private:
+  friend class GstByteAdapter;
+  GstAdapterSpan(GstByteAdapter *adapter, const std::uint8_t *data,
+                 std::size_t size) noexcept
+      : m_adapter(adapter), m_data(data), m_size(size) {}
+
+  GstByteAdapter *m_adapter;
+  const std::uint8_t *m_data;
+  std::size_t m_size;
+};
+
+/// Timestamps of the chunk a byte of the stream came from
+struct GstAdapterTimestamp {
+  GstClockTime pts = GST_CLOCK_TIME_NONE;
+  GstClockTime dts = GST_CLOCK_TIME_NONE;
+  /// Byte offset in the stream, extrapolated from the last GST_BUFFER_OFFSET
+  /// seen. Only meaningful when buffer offsets count bytes.
+  guint64 offset = GST_BUFFER_OFFSET_NONE;
+  /// Bytes between the start of the chunk holding pts/dts and the byte
+  guint64 distance = 0;
+};
+
+/// Zero-copy stream assembly over a GstAdapter
+/// @note Not thread-safe, like GstAdapter itself. Not copyable nor movable:
+/// spans refer to it.
+class GstByteAdapter {
+public:
+  struct Stats {
+    guint64 bytesPushed = 0;
+    guint64 bytesTaken = 0;
+    /// Bytes memcpy'd to serve peek() calls spanning several chunks
+    guint64 bytesCopied = 0;
+  };
+
+  GstByteAdapter() : m_adapter(gst_adapter_new()) {}
+
+  GstByteAdapter(const GstByteAdapter &) = delete;
+  GstByteAdapter &operator=(const GstByteAdapter &) = delete;
+  GstByteAdapter(GstByteAdapter &&) = delete;
+  GstByteAdapter &operator=(GstByteAdapter &&) = delete;
+
+  /// Appends a chunk, taking the reference held by \p buffer
+  void push(GstPtr<GstBuffer> &&buffer) {
+    if (!buffer) {
+      return;
+    }
+    m_stats.bytesPushed += gst_buffer_get_size(buffer.self());
+    gst_adapter_push(m_adapter.self(), buffer.transferFull());
+  }
+
+  /// Bytes available
+  [[nodiscard]] std::size_t available() const noexcept {
+    return gst_adapter_available(m_adapter.self());
+  }
+
+  /// Bytes that can be peeked without copying
+  [[nodiscard]] std::size_t availableContiguous() const noexcept {
+    return gst_adapter_available_fast(m_adapter.self());
+  }
+
+  /// Peeks the first \p size bytes, only if no copy is needed
+  /// @return std::nullopt if there aren't enough contiguous bytes
+  /// @throws std::logic_error if a GstAdapterSpan is alive
+  [[nodiscard]] std::optional<GstAdapterSpan> peekContiguous(std::size_t size) {
+    checkNotMapped("peekContiguous");
+    if (size == 0 || size > availableContiguous()) {
+      return std::nullopt;
+    }
+    return map(size);
+  }
+
+  /// Peeks the first \p size bytes, copying them if they span several chunks
+  /// @return std::nullopt if there aren't enough bytes
+  /// @throws std::logic_error if a GstAdapterSpan is alive
+  [[nodiscard]] std::optional<GstAdapterSpan> peek(std::size_t size) {
+    checkNotMapped("peek");
+    if (size == 0 || size > available()) {
+      return std::nullopt;
+    }
+    if (size > availableContiguous()) {
+      m_stats.bytesCopied += size;
+    }
+    return map(size);
+  }
+
+  /// Takes the first \p size bytes as a buffer made of sub-buffers of the
+  /// pushed chunks (no memcpy).
+  /// @return nullptr if there aren't enough bytes
+  /// @throws std::logic_error if a GstAdapterSpan is alive
+  [[nodiscard]] GstPtr<GstBuffer> takeBuffer(std::size_t size) {
+    checkNotMapped("takeBuffer");
+    if (size == 0 || size > available()) {
+      return {};
+    }
+    m_stats.bytesTaken += size;
+    return gst_adapter_take_buffer_fast(m_adapter.self(), size);
+  }
+
+  /// Drops the first \p size bytes
+  /// @throws std::logic_error if a GstAdapterSpan is alive
+  void flush(std::size_t size) {
+    checkNotMapped("flush");
+    size = std::min(size, available());
+    if (size != 0) {
+      gst_adapter_flush(m_adapter.self(), size);
+    }
+  }
+
+  /// Drops everything, and resets timestamp tracking
+  /// @throws std::logic_error if a GstAdapterSpan is alive
+  void clear() {
+    checkNotMapped("clear");
+    gst_adapter_clear(m_adapter.self());
+  }
+
+  /// Finds the first offset, starting at \p offset, where the next 4 bytes
+  /// read as a big-endian uint32 satisfy `(value & mask) == pattern`.
+  /// @return The offset, or -1 if not found
+  /// @throws std::logic_error if a GstAdapterSpan is alive, as the scan maps
+  /// the adapter too
+  [[nodiscard]] gssize maskedScan(std::uint32_t mask, std::uint32_t pattern,
+                                  std::size_t offset = 0) {
+    checkNotMapped("maskedScan");
+    const std::size_t total = available();
+    if (offset + 4 > total) {
+      return -1;
+    }
+    // Scan the first chunk, which can be mapped without copying
+    const std::size_t contiguous = availableContiguous();
+    std::size_t resumeAt = offset;
+    if (offset + 4 <= contiguous) {
+      const auto *data = static_cast<const std::uint8_t *>(
+          gst_adapter_map(m_adapter.self(), contiguous));
+      const std::ptrdiff_t found =
+          maskedScanUint32(data + offset, contiguous - offset, mask, pattern);
+      gst_adapter_unmap(m_adapter.self());
+      if (found >= 0) {
+        return static_cast<gssize>(offset + found);
+      }
+      // The last 3 positions may start a match that continues in next chunk
+      resumeAt = contiguous - 3;
+    }
+    if (resumeAt + 4 > total) {
+      return -1;
+    }
+    return gst_adapter_masked_scan_uint32_peek(
+        m_adapter.self(), mask, pattern, resumeAt, total - resumeAt, nullptr);
+  }
+
+  /// Timestamps of the chunk that contains the byte at \p offset
+  [[nodiscard]] GstAdapterTimestamp timestampAt(std::size_t offset) const {
+    GstAdapterTimestamp timestamp;
+    timestamp.pts = gst_adapter_prev_pts_at_offset(m_adapter.self(), offset,
+                                                   &timestamp.distance);
+    guint64 dtsDistance = 0;
+    timestamp.dts = gst_adapter_prev_dts_at_offset(m_adapter.self(), offset,
+                                                   &dtsDistance);
+    guint64 offsetDistance = 0;
+    timestamp.offset =
+        gst_adapter_prev_offset(m_adapter.self(), &offsetDistance);
+    if (timestamp.offset != GST_BUFFER_OFFSET_NONE) {
+      // prev_offset refers to the head of the adapter: move it to the byte
+      timestamp.offset += offsetDistance + offset;
+    }
+    return timestamp;
+  }
+
+  [[nodiscard]] const Stats &stats() const noexcept { return m_stats; }
+
+  /// The wrapped GstAdapter
+  [[nodiscard]] GstAdapter *self() const noexcept { return m_adapter.self(); }
+
+private:
+  friend class GstAdapterSpan;
+
+  void checkNotMapped(const char *method) const {
+    if (m_mapped) {
+      throw std::logic_error(std::string("GstByteAdapter: ") + method +
+                             "() while a GstAdapterSpan is alive");
+    }
+  }
+
+  GstAdapterSpan map(std::size_t size) noexcept {
+    const auto *data = static_cast<const std::uint8_t *>(
+        gst_adapter_map(m_adapter.self(), size));
+    m_mapped = true;
+    return GstAdapterSpan{this, data, size};
+  }
+
+  void unmap() noexcept {
+    gst_adapter_unmap(m_adapter.self());
+    m_mapped = false;
+  }
+
+  GstPtr<GstAdapter> m_adapter;
+  Stats m_stats;
+  bool m_mapped = false;
+};
+
+GstAdapterSpan::~GstAdapterSpan() {
+  if (m_adapter != nullptr) {
+    m_adapter->unmap();
+  }
+}
+
+#endif
@@ -0,0 +1,408 @@
+/*
+ *  GstAppSrcFeeder pushes into an appsrc following its flow control signals.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17 and gst-app (gstreamer-app-1.0)
+ *
+ */
+
+/*
+An appsrc queues whatever it is pushed. If the producer never looks at
+need-data/enough-data, the queue either grows without bound or runs empty.
+GstAppSrcFeeder installs the appsrc callbacks and makes the producer wait:
+
+ GstAppSrcFeeder feeder{appsrc, {4 * 1024 * 1024}};   // max 4 MiB queued
+ feeder.onSeek([](guint64 offset) { return reader.seek(offset); });
+
+ // producer thread
+ GstPtr<GstBuffer> buffer = ...;
+ if (feeder.push(std::move(buffer)) != GstFeedResult::accepted) { ... }
+ ...
+ feeder.endOfStream();
+
+- push() takes the reference held by the GstPtr (no extra ref). It returns
+  immediately while the appsrc asks for data. After enough-data, buffers are
+  collected in a GstBufferList of up to batchSize buffers, and the producer
+  blocks (optionally with a timeout) once the list is full, until need-data.
+  The whole list is then pushed in a single call.
+  On timeout or stop() the buffer is left in the caller's GstPtr.
+- tryPush() never blocks: it returns GstFeedResult::timedOut instead.
+- onReady() is called (from the streaming thread) on every need-data, so
+  event-loop producers can resume instead of blocking.
+- stats() reports the appsrc queue depth, the time producers spent blocked,
+  and how many times the appsrc starved or was full.
+
+The watermarks are the appsrc max-bytes/max-buffers/max-time properties
+(buffers and time need GStreamer 1.20), so enough-data fires when any of them
+is exceeded. appsrc "block" should stay false: the feeder does the blocking.
+
+GstAppSrcFeeder replaces any callbacks set on the appsrc, and it must outlive
+the streaming of the appsrc (set the pipeline to NULL before destroying it).
+push() may be called from several producer threads.
+
+GstBufferList and GstAppSrc are also mapped for GstPtr<>.
+
+Only the GstBufferList mapping is defined unless <gst/app/gstappsrc.h> can be
+included.
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+
+namespace detail {
+struct IGstBufferList : IGstMiniObject {};
+GST_PTR_MAP_INTERFACE_WITH_TYPE(GstBufferList, GST_TYPE_BUFFER_LIST)
+} // namespace detail
+
+#if __has_include(<gst/app/gstappsrc.h>)
+#include <gst/app/gstappsrc.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace detail {
+struct IGstAppSrc : IGstElement {};
+GST_PTR_MAP_INTERFACE_WITH_TYPE(GstAppSrc, GST_TYPE_APP_SRC)
+} // namespace detail
+
+enum class GstFeedResult {
+  /// Pushed to the appsrc, or queued in the pending batch
+  accepted,
+  /// The appsrc queue stayed full; the buffer was not taken
+  timedOut,
+  /// stop() was called; the buffer was not taken
+  stopped,
+  /// The appsrc refused the data (flushing, EOS...)
+  flowError
+};
+
+/// Flow-controlled producer side of an appsrc
+class GstAppSrcFeeder {
+public:
+  /// Limits of the appsrc queue. Zero leaves the appsrc default.
+  struct Watermarks {
+    guint64 maxBytes = 0;
+    guint64 maxBuffers = 0;
+    GstClockTime maxTime = 0;
+  };
+
+  struct Stats {
+    /// Current appsrc queue depth
+    guint64 queuedBytes = 0;
+    guint64 queuedBuffers = 0;
+    GstClockTime queuedTime = 0;
+    /// Buffers waiting in the pending batch
+    guint pendingBuffers = 0;
+    /// Time producers spent blocked in push()
+    std::chrono::nanoseconds stallTime{0};
+    guint64 stalls = 0;
+    guint64 needData = 0;
+    guint64 enoughData = 0;
+    guint64 buffersPushed = 0;
+    guint64 listsPushed = 0;
+  };
+
+  /// @throws std::bad_cast if \p appsrc is not an appsrc
+  GstAppSrcFeeder(const GstPtr<GstElement> &appsrc, const Watermarks &watermarks,
+                  guint batchSize = 16)
+      : m_element(appsrc), m_appsrc(appsrc.selfDynamic<GstAppSrc>()),
+        m_batchSize(batchSize == 0 ? 1 : batchSize) {
+    if (watermarks.maxBytes != 0) {
+      gst_app_src_set_max_bytes(m_appsrc, watermarks.maxBytes);
+    }
+#if GST_CHECK_VERSION(1, 20, 0)
+    if (watermarks.maxBuffers != 0) {
+      gst_app_src_set_max_buffers(m_appsrc, watermarks.maxBuffers);
+    }
+    if (watermarks.maxTime != 0) {
+      gst_app_src_set_max_time(m_appsrc, watermarks.maxTime);
+    }
+#endif
+    GstAppSrcCallbacks callbacks{};
+    callbacks.need_data = &GstAppSrcFeeder::needData;
+    callbacks.enough_data = &GstAppSrcFeeder::enoughData;
+    callbacks.seek_data = &GstAppSrcFeeder::seekData;
+    gst_app_src_set_callbacks(m_appsrc, &callbacks, this, nullptr);
+  }
+
+  GstAppSrcFeeder(const GstAppSrcFeeder &) = delete;
+  GstAppSrcFeeder &operator=(const GstAppSrcFeeder &) = delete;
+
+  ~GstAppSrcFeeder() {
+    stop();
+    GstAppSrcCallbacks callbacks{};
+    gst_app_src_set_callbacks(m_appsrc, &callbacks, nullptr, nullptr);
+  }
+
+  /// Pushes \p buffer, taking its reference, and blocks while the appsrc
+  /// queue is full and the pending batch too, up to \p timeout.
+  GstFeedResult push(GstPtr<GstBuffer> &&buffer,
+                     std::chrono::nanoseconds timeout =
+                         std::chrono::nanoseconds::max()) {
+    if (!buffer) {
+      return GstFeedResult::accepted;
+    }
+    const auto deadline = deadlineAfter(timeout);
+    {
+      std::unique_lock<std::mutex> lock(m_stateMutex);
+      if (m_stopped) {
+        return GstFeedResult::stopped;
+      }
+      if (!m_accepting) {
+        // The producer is ahead: batch until the list is full
+        if (pendingLength() < m_batchSize) {
+          appendPending(std::move(buffer));
+          return GstFeedResult::accepted;
+        }
+        if (timeout == std::chrono::nanoseconds::zero()) {
+          return GstFeedResult::timedOut;
+        }
+        if (!waitAccepting(lock, deadline)) {
+          return m_stopped ? GstFeedResult::stopped : GstFeedResult::timedOut;
+        }
+      }
+      // Another producer may be pushing: wait for it, within the same timeout
+      if (!takePushTurn(lock, deadline)) {
+        return GstFeedResult::timedOut;
+      }
+    }
+    // Not holding the state lock: appsrc may call enoughData() from here
+    GstFeedResult result = flushPending();
+    if (result == GstFeedResult::accepted) {
+      result =
+          toResult(gst_app_src_push_buffer(m_appsrc, buffer.transferFull()));
+    }
+    endPushTurn(result == GstFeedResult::accepted ? 1 : 0);
+    return result;
+  }
+
+  /// Like push(), but never blocks: GstFeedResult::timedOut if the batch is
+  /// full or another producer is pushing
+  GstFeedResult tryPush(GstPtr<GstBuffer> &&buffer) {
+    return push(std::move(buffer), std::chrono::nanoseconds::zero());
+  }
+
+  /// Pushes the pending batch, if any, regardless of the queue level
+  GstFeedResult flush() {
+    {
+      std::unique_lock<std::mutex> lock(m_stateMutex);
+      takePushTurn(lock, std::nullopt);
+    }
+    const GstFeedResult result = flushPending();
+    endPushTurn();
+    return result;
+  }
+
+  /// Pushes the pending batch and signals end of stream
+  GstFeedResult endOfStream() {
+    {
+      std::unique_lock<std::mutex> lock(m_stateMutex);
+      takePushTurn(lock, std::nullopt);
+    }
+    GstFeedResult result = flushPending();
+    if (result == GstFeedResult::accepted) {
+      result = toResult(gst_app_src_end_of_stream(m_appsrc));
+    }
+    endPushTurn();
+    return result;
+  }
+
+  /// Wakes up blocked producers, and makes further pushes fail
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(m_stateMutex);
+      m_stopped = true;
+    }
+    m_accepted.notify_all();
+  }
+
+  /// Called, from the streaming thread, when appsrc asks for data
+  void onReady(std::function<void()> ready) {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_ready = std::move(ready);
+  }
+
+  /// Called, from the streaming thread, when appsrc seeks to an offset.
+  /// The pending batch is dropped before calling it.
+  void onSeek(std::function<bool(guint64)> seek) {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_seek = std::move(seek);
+  }
+
+  [[nodiscard]] Stats stats() const {
+    Stats stats;
+    {
+      std::lock_guard<std::mutex> lock(m_stateMutex);
+      stats = m_stats;
+      stats.pendingBuffers = pendingLength();
+    }
+    stats.queuedBytes = gst_app_src_get_current_level_bytes(m_appsrc);
+#if GST_CHECK_VERSION(1, 20, 0)
+    stats.queuedBuffers = gst_app_src_get_current_level_buffers(m_appsrc);
+    stats.queuedTime = gst_app_src_get_current_level_time(m_appsrc);
+#endif
+    return stats;
+  }
+
+  /// The appsrc
+  [[nodiscard]] GstAppSrc *self() const noexcept { return m_appsrc; }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /// No deadline for nanoseconds::max()
+  static std::optional<Clock::time_point>
+  deadlineAfter(std::chrono::nanoseconds timeout) {
+    const auto now = Clock::now();
+    if (timeout >= Clock::time_point::max() - now) {
+      return std::nullopt;
+    }
+    return now + timeout;
+  }
+
+  /// m_stateMutex held. Waits until no other thread is calling the appsrc
+  /// push functions, and takes the turn. Returns false on timeout.
+  bool takePushTurn(std::unique_lock<std::mutex> &lock,
+                    const std::optional<Clock::time_point> &deadline) {
+    const auto idle = [this] { return !m_pushing; };
+    if (!deadline) {
+      m_pushIdle.wait(lock, idle);
+    } else if (!m_pushIdle.wait_until(lock, *deadline, idle)) {
+      return false;
+    }
+    m_pushing = true;
+    return true;
+  }
+
+  void endPushTurn(guint64 buffersPushed = 0) {
+    {
+      std::lock_guard<std::mutex> lock(m_stateMutex);
+      m_pushing = false;
+      m_stats.buffersPushed += buffersPushed;
+    }
+    m_pushIdle.notify_one();
+  }
+
+  static GstFeedResult toResult(GstFlowReturn flow) noexcept {
+    return flow == GST_FLOW_OK ? GstFeedResult::accepted
+                               : GstFeedResult::flowError;
+  }
+
+  /// m_stateMutex held
+  guint pendingLength() const {
+    return m_pending ? gst_buffer_list_length(m_pending.self()) : 0;
+  }
+
+  /// m_stateMutex held
+  void appendPending(GstPtr<GstBuffer> &&buffer) {
+    if (!m_pending) {
+      m_pending = gst_buffer_list_new_sized(m_batchSize);
+    }
+    gst_buffer_list_add(m_pending.self(), buffer.transferFull());
+  }
+
+  /// m_stateMutex held. Returns false on timeout or stop.
+  bool waitAccepting(std::unique_lock<std::mutex> &lock,
+                     const std::optional<Clock::time_point> &deadline) {
+    const auto start = Clock::now();
+    const auto ready = [this] { return m_accepting || m_stopped; };
+    if (!deadline) {
+      m_accepted.wait(lock, ready);
+    } else {
+      m_accepted.wait_until(lock, *deadline, ready);
+    }
+    ++m_stats.stalls;
+    m_stats.stallTime += Clock::now() - start;
+    return m_accepting && !m_stopped;
+  }
+
+  /// Push turn taken
+  GstFeedResult flushPending() {
+    GstPtr<GstBufferList> pending;
+    {
+      std::lock_guard<std::mutex> lock(m_stateMutex);
+      std::swap(pending, m_pending);
+      if (pending) {
+        ++m_stats.listsPushed;
+        m_stats.buffersPushed += gst_buffer_list_length(pending.self());
+      }
+    }
+    if (!pending) {
+      return GstFeedResult::accepted;
+    }
+    return toResult(
+        gst_app_src_push_buffer_list(m_appsrc, pending.transferFull()));
+  }
+
+  static void needData(GstAppSrc * /*appsrc*/, guint /*length*/,
+                       gpointer userData) {
+    auto *self = static_cast<GstAppSrcFeeder *>(userData);
+    std::function<void()> ready;
+    bool flush = false;
+    {
+      std::lock_guard<std::mutex> lock(self->m_stateMutex);
+      self->m_accepting = true;
+      ++self->m_stats.needData;
+      ready = self->m_ready;
+      // Starving with a batch pending: push it now unless a producer is
+      // already pushing (it will flush it).
+      if (!self->m_pushing && self->m_pending) {
+        self->m_pushing = true;
+        flush = true;
+      }
+    }
+    self->m_accepted.notify_all();
+    if (flush) {
+      self->flushPending();
+      self->endPushTurn();
+    }
+    if (ready) {
+      ready();
+    }
+  }
+
+  static void enoughData(GstAppSrc * /*appsrc*/, gpointer userData) {
+    auto *self = static_cast<GstAppSrcFeeder *>(userData);
+    std::lock_guard<std::mutex> lock(self->m_stateMutex);
+    self->m_accepting = false;
+    ++self->m_stats.enoughData;
+  }
+
+  static gboolean seekData(GstAppSrc * /*appsrc*/, guint64 offset,
+                           gpointer userData) {
+    auto *self = static_cast<GstAppSrcFeeder *>(userData);
+    std::function<bool(guint64)> seek;
+    GstPtr<GstBufferList> dropped;
+    {
+      std::lock_guard<std::mutex> lock(self->m_stateMutex);
+      std::swap(dropped, self->m_pending);
+      seek = self->m_seek;
+    }
+    return seek && seek(offset) ? TRUE : FALSE;
+  }
+
+  GstPtr<GstElement> m_element;
+  GstAppSrc *m_appsrc;
+  const guint m_batchSize;
+
+  /// Protects the members below. Never held across appsrc calls.
+  mutable std::mutex m_stateMutex;
+  std::condition_variable m_accepted;
+  /// A thread is calling the appsrc push functions. Pushes take turns, to keep
+  /// the buffer order, but nobody waits for need-data while holding a turn.
+  bool m_pushing = false;
+  std::condition_variable m_pushIdle;
+  bool m_accepting = true;
+  bool m_stopped = false;
+  GstPtr<GstBufferList> m_pending;
+  std::function<void()> m_ready;
+  std::function<bool(guint64)> m_seek;
+  Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ *  Byte pattern scans over contiguous memory, for parsers.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+maskedScanUint32() has the semantics of gst_adapter_masked_scan_uint32(): it
+returns the first offset where the next 4 bytes, read as a big-endian uint32
+and ANDed with `mask`, equal `pattern`.
+
+Most patterns used by parsers (start codes, sync words) fix their first byte,
+so candidates are searched with memchr(), which standard libraries implement
+with vector instructions, and only the candidates are checked. Other masks
+fall back to a byte-by-byte rolling compare.
+
+ auto found = maskedScanUint32(data, size, START_CODE_MASK, START_CODE_PATTERN);
+ if (found >= 0) { ... }   // offset of 00 00 01 xx
+
+This header doesn't need GStreamer.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/// Mask/pattern of an Annex B / MPEG start code prefix (00 00 01 xx)
+constexpr std::uint32_t START_CODE_MASK = 0xffffff00U;
+constexpr std::uint32_t START_CODE_PATTERN = 0x00000100U;
+
+namespace detail {
+
+inline std::uint32_t readUint32BigEndian(const std::uint8_t *data) noexcept {
+  return (static_cast<std::uint32_t>(data[0]) << 24U) |
+         (static_cast<std::uint32_t>(data[1]) << 16U) |
+         (static_cast<std::uint32_t>(data[2]) << 8U) |
+         static_cast<std::uint32_t>(data[3]);
+}
+
+} // namespace detail
+
+/// Finds the first offset where `(uint32 at offset & mask) == pattern`
+/// @return The offset, or -1 if not found
+[[nodiscard]] inline std::ptrdiff_t
+maskedScanUint32(const std::uint8_t *data, std::size_t size, std::uint32_t mask,
+                 std::uint32_t pattern) noexcept {
+  if (data == nullptr || size < 4) {
+    return -1;
+  }
+  const std::size_t lastStart = size - 4;
+
+  if ((mask >> 24U) == 0xffU) {
+    const auto firstByte = static_cast<int>(pattern >> 24U);
+    std::size_t position = 0;
+    while (position <= lastStart) {
+      const void *hit =
+          std::memchr(data + position, firstByte, lastStart - position + 1);
+      if (hit == nullptr) {
+        return -1;
+      }
+      position = static_cast<std::size_t>(static_cast<const std::uint8_t *>(hit) -
+                                          data);
+      if ((detail::readUint32BigEndian(data + position) & mask) == pattern) {
+        return static_cast<std::ptrdiff_t>(position);
+      }
+      ++position;
+    }
+    return -1;
+  }
+
+  std::uint32_t state = detail::readUint32BigEndian(data);
+  if ((state & mask) == pattern) {
+    return 0;
+  }
+  for (std::size_t index = 4; index < size; ++index) {
+    state = (state << 8U) | data[index];
+    if ((state & mask) == pattern) {
+      return static_cast<std::ptrdiff_t>(index - 3);
+    }
+  }
+  return -1;
+}
+
+/// Finds the first start code prefix (00 00 01)
+/// @return The offset of its first zero, or -1 if not found
+[[nodiscard]] inline std::ptrdiff_t findStartCode(const std::uint8_t *data,
+                                                  std::size_t size) noexcept {
+  return maskedScanUint32(data, size, START_CODE_MASK, START_CODE_PATTERN);
+}
+
+/// Finds the first offset where \p syncByte repeats every \p packetSize bytes
+/// \p confirmations more times (i.e. 0x47 and 188 for MPEG-TS)
+/// @return The offset, or -1 if not found
+[[nodiscard]] inline std::ptrdiff_t
+findSyncByte(const std::uint8_t *data, std::size_t size, std::uint8_t syncByte,
+             std::size_t packetSize, std::size_t confirmations = 2) noexcept {
+  if (data == nullptr || packetSize == 0) {
+    return -1;
+  }
+  const std::size_t span = packetSize * confirmations;
+  std::size_t position = 0;
+  while (position + span < size) {
+    const void *hit =
+        std::memchr(data + position, syncByte, size - span - position);
+    if (hit == nullptr) {
+      return -1;
+    }
+    position = static_cast<std::size_t>(static_cast<const std::uint8_t *>(hit) -
+                                        data);
+    bool confirmed = true;
+    for (std::size_t packet = 1; packet <= confirmations && confirmed;
+         ++packet) {
+      confirmed = data[position + packet * packetSize] == syncByte;
+    }
+    if (confirmed) {
+      return static_cast<std::ptrdiff_t>(position);
+    }
+    ++position;
+  }
+  return -1;
+}
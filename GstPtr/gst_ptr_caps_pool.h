@@ -0,0 +1,407 @@
+/*
+ *  GstCapsPool interns GstCaps, so equal caps share a single instance.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+gst_caps_is_equal() and gst_caps_can_intersect() walk both caps structure by
+structure, field by field. Code that compares the same few caps over and over
+(routing, renegotiation checks...) can pay that walk once, when the caps are
+interned, and then compare pointers:
+
+ GstCapsPool pool;
+
+ GstInternedCaps a = pool.intern(caps);           // hash + lookup, may insert
+ GstInternedCaps b = pool.intern(otherCaps);
+ if (a == b) { ... }                              // pointer compare
+
+ GstInternedCaps common = pool.intersect(a, b);   // memoized per (a, b)
+ GstInternedCaps fixed = pool.fixate(common);     // memoized per caps
+
+- The pool keeps a reference to every canonical instance. Interned caps are
+  shared, so they are never writable: gst_caps_make_writable() will copy them.
+- Intersect/can-intersect/fixate results are kept in a bounded LRU cache.
+- Everything is thread-safe. The pool is split in shards, each one with its
+  own lock, so threads interning different caps rarely contend.
+- Fixed caps are hashed by name, features and field values. Non-fixed caps
+  are only hashed by their structure names, so many of them sharing a media
+  type end up in the same bucket and are told apart with gst_caps_is_equal().
+  Equal caps written in a degenerate form (i.e. a duplicated structure, which
+  makes them non-fixed) may intern to a different instance than their fixed
+  equivalent; pointer equality never reports unequal caps as equal.
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Caps returned by a GstCapsPool. Equality is a pointer compare.
+class GstInternedCaps {
+public:
+  GstInternedCaps() noexcept = default;
+
+  /// The canonical caps. Don't modify them: they are shared.
+  [[nodiscard]] const GstPtr<GstCaps> &caps() const noexcept { return m_caps; }
+
+  /// Pass the inner raw pointer to a parameter that doesn't take ownership.
+  [[nodiscard]] GstCaps *self() const noexcept { return m_caps.self(); }
+
+  /// Returns true if it holds caps
+  explicit operator bool() const noexcept { return static_cast<bool>(m_caps); }
+
+  friend bool operator==(const GstInternedCaps &lhs,
+                         const GstInternedCaps &rhs) noexcept {
+    return lhs.self() == rhs.self();
+  }
+  friend bool operator!=(const GstInternedCaps &lhs,
+                         const GstInternedCaps &rhs) noexcept {
+    return lhs.self() != rhs.self();
+  }
+
+private:
+  friend class GstCapsPool;
+  explicit GstInternedCaps(GstPtr<GstCaps> caps) noexcept
+      : m_caps(std::move(caps)) {}
+
+  GstPtr<GstCaps> m_caps;
+};
+
+namespace std {
+template <> struct hash<GstInternedCaps> {
+  std::size_t operator()(const GstInternedCaps &caps) const noexcept {
+    return std::hash<const void *>{}(caps.self());
+  }
+};
+} // namespace std
+
+namespace detail {
+
+inline std::size_t mixCapsHash(std::size_t value) noexcept {
+  // splitmix64 finalizer, so sums of field hashes don't cancel out easily
+  std::uint64_t mixed = value;
+  mixed = (mixed ^ (mixed >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+  mixed = (mixed ^ (mixed >> 27U)) * 0x94d049bb133111ebULL;
+  return static_cast<std::size_t>(mixed ^ (mixed >> 31U));
+}
+
+// Hash of a field value. Values of types not handled here only contribute
+// their type, which is still consistent with gst_value_compare().
+inline std::size_t hashCapsFieldValue(const GValue *value) noexcept {
+  const GType type = G_VALUE_TYPE(value);
+  std::size_t hash = type;
+  if (type == G_TYPE_INT) {
+    hash ^= mixCapsHash(static_cast<std::size_t>(g_value_get_int(value)));
+  } else if (type == G_TYPE_UINT) {
+    hash ^= mixCapsHash(g_value_get_uint(value));
+  } else if (type == G_TYPE_INT64) {
+    hash ^= mixCapsHash(static_cast<std::size_t>(g_value_get_int64(value)));
+  } else if (type == G_TYPE_UINT64) {
+    hash ^= mixCapsHash(static_cast<std::size_t>(g_value_get_uint64(value)));
+  } else if (type == G_TYPE_BOOLEAN) {
+    hash ^= mixCapsHash(g_value_get_boolean(value) != FALSE ? 1U : 2U);
+  } else if (type == G_TYPE_STRING) {
+    const gchar *content = g_value_get_string(value);
+    hash ^= std::hash<std::string_view>{}(content != nullptr ? content : "");
+  } else if (type == GST_TYPE_FRACTION) {
+    // Fractions are compared by value (2/4 == 1/2), so hash the ratio
+    const gint numerator = gst_value_get_fraction_numerator(value);
+    const gint denominator = gst_value_get_fraction_denominator(value);
+    const gdouble ratio =
+        denominator != 0 ? static_cast<gdouble>(numerator) / denominator : 0.0;
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &ratio, sizeof(bits));
+    hash ^= mixCapsHash(static_cast<std::size_t>(bits));
+  }
+  return hash;
+}
+
+inline gboolean hashCapsField(GQuark fieldId, const GValue *value,
+                              gpointer userData) noexcept {
+  // A sum, because field order doesn't matter for equality
+  *static_cast<std::size_t *>(userData) +=
+      mixCapsHash(fieldId ^ (hashCapsFieldValue(value) << 1U));
+  return TRUE;
+}
+
+inline std::size_t hashCapsFeatures(const GstCapsFeatures *features) noexcept {
+  std::size_t hash = 0;
+  if (features != nullptr) {
+    const guint count = gst_caps_features_get_size(features);
+    for (guint i = 0; i < count; ++i) {
+      hash += mixCapsHash(gst_caps_features_get_nth_id(features, i));
+    }
+  }
+  return hash;
+}
+
+// Consistent with gst_caps_is_equal(): equal caps always hash the same, as
+// long as both are fixed or both are not.
+inline std::size_t hashCaps(const GstCaps *caps) noexcept {
+  if (gst_caps_is_any(caps) != FALSE) {
+    return 1;
+  }
+  if (gst_caps_is_empty(caps) != FALSE) {
+    return 2;
+  }
+  if (gst_caps_is_fixed(caps) != FALSE) {
+    const GstStructure *structure = gst_caps_get_structure(caps, 0);
+    std::size_t hash = mixCapsHash(gst_structure_get_name_id(structure)) ^
+                       hashCapsFeatures(gst_caps_get_features(caps, 0));
+    gst_structure_foreach(structure, &hashCapsField, &hash);
+    return hash;
+  }
+  // Non-fixed caps are equal if each one is a subset of the other, which can
+  // hold with different structures, so only the set of names is reliable.
+  std::vector<GQuark> names;
+  const guint size = gst_caps_get_size(caps);
+  names.reserve(size);
+  for (guint i = 0; i < size; ++i) {
+    names.push_back(
+        gst_structure_get_name_id(gst_caps_get_structure(caps, i)));
+  }
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+  std::size_t hash = 3;
+  for (GQuark name : names) {
+    hash = mixCapsHash(hash ^ name);
+  }
+  return hash;
+}
+
+} // namespace detail
+
+/// Interning cache for GstCaps, with memoized intersect/fixate.
+class GstCapsPool {
+public:
+  /// Hit/miss counters. They are updated with relaxed atomics, so a snapshot
+  /// taken while other threads work is only approximately consistent.
+  struct Stats {
+    std::uint64_t internHits = 0;
+    std::uint64_t internMisses = 0;
+    std::uint64_t memoHits = 0;
+    std::uint64_t memoMisses = 0;
+
+    [[nodiscard]] double internHitRate() const noexcept {
+      return rate(internHits, internMisses);
+    }
+    [[nodiscard]] double memoHitRate() const noexcept {
+      return rate(memoHits, memoMisses);
+    }
+
+  private:
+    static double rate(std::uint64_t hits, std::uint64_t misses) noexcept {
+      const std::uint64_t total = hits + misses;
+      return total != 0 ? static_cast<double>(hits) / total : 0.0;
+    }
+  };
+
+  /// @param memoCapacity maximum number of memoized intersect/fixate results
+  explicit GstCapsPool(std::size_t memoCapacity = 4096)
+      : m_memoCapacityPerShard(std::max<std::size_t>(1, memoCapacity / SHARDS)) {}
+
+  GstCapsPool(const GstCapsPool &) = delete;
+  GstCapsPool &operator=(const GstCapsPool &) = delete;
+
+  /// Returns the canonical instance of caps equal to \p caps.
+  /// The first time some caps are seen, \p caps becomes the canonical instance.
+  [[nodiscard]] GstInternedCaps intern(const GstPtr<GstCaps> &caps) {
+    if (!caps) {
+      return {};
+    }
+    const std::size_t hash = detail::hashCaps(caps.self());
+    Shard &shard = shardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto &bucket = shard.interned[hash];
+    for (const auto &candidate : bucket) {
+      if (candidate.self() == caps.self() ||
+          gst_caps_is_equal(candidate.self(), caps.self()) != FALSE) {
+        m_internHits.fetch_add(1, std::memory_order_relaxed);
+        return GstInternedCaps{candidate};
+      }
+    }
+    m_internMisses.fetch_add(1, std::memory_order_relaxed);
+    bucket.push_back(caps);
+    return GstInternedCaps{caps};
+  }
+
+  /// Memoized gst_caps_intersect(\p first, \p second)
+  [[nodiscard]] GstInternedCaps intersect(const GstInternedCaps &first,
+                                          const GstInternedCaps &second) {
+    return memoized(Operation::intersect, first, second, [&] {
+      GstPtr<GstCaps> result = gst_caps_intersect(first.self(), second.self());
+      return intern(result);
+    });
+  }
+
+  /// Memoized gst_caps_can_intersect(\p first, \p second)
+  [[nodiscard]] bool canIntersect(const GstInternedCaps &first,
+                                  const GstInternedCaps &second) {
+    if (first == second) {
+      return !gst_caps_is_empty(first.self());
+    }
+    // The result is stored as its own caps: nullptr means "no"
+    GstInternedCaps result =
+        memoized(Operation::canIntersect, first, second, [&] {
+          return gst_caps_can_intersect(first.self(), second.self()) != FALSE
+                     ? first
+                     : GstInternedCaps{};
+        });
+    return static_cast<bool>(result);
+  }
+
+  /// Memoized gst_caps_fixate(\p caps)
+  [[nodiscard]] GstInternedCaps fixate(const GstInternedCaps &caps) {
+    return memoized(Operation::fixate, caps, GstInternedCaps{}, [&] {
+      // fixate() takes ownership and makes the caps writable (a copy, here)
+      GstPtr<GstCaps> toFixate = caps.caps();
+      GstPtr<GstCaps> result = gst_caps_fixate(toFixate.transferFull());
+      return intern(result);
+    });
+  }
+
+  [[nodiscard]] Stats stats() const noexcept {
+    Stats stats;
+    stats.internHits = m_internHits.load(std::memory_order_relaxed);
+    stats.internMisses = m_internMisses.load(std::memory_order_relaxed);
+    stats.memoHits = m_memoHits.load(std::memory_order_relaxed);
+    stats.memoMisses = m_memoMisses.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  /// Number of canonical caps held by the pool
+  [[nodiscard]] std::size_t size() const {
+    std::size_t total = 0;
+    for (const Shard &shard : m_shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (const auto &bucket : shard.interned) {
+        total += bucket.second.size();
+      }
+    }
+    return total;
+  }
+
+  /// Drops the memoized results, and then the canonical caps that nobody
+  /// else references anymore.
+  void purgeUnused() {
+    for (Shard &shard : m_shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.memoIndex.clear();
+      shard.memoLru.clear();
+    }
+    for (Shard &shard : m_shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (auto it = shard.interned.begin(); it != shard.interned.end();) {
+        auto &bucket = it->second;
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(),
+                                    [](const GstPtr<GstCaps> &caps) {
+                                      return GST_MINI_OBJECT_REFCOUNT_VALUE(
+                                                 caps.self()) == 1;
+                                    }),
+                     bucket.end());
+        it = bucket.empty() ? shard.interned.erase(it) : std::next(it);
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t SHARDS = 16;
+
+  enum class Operation { intersect, canIntersect, fixate };
+
+  struct MemoKey {
+    GstCaps *first;
+    GstCaps *second;
+    Operation operation;
+
+    bool operator==(const MemoKey &other) const noexcept {
+      return first == other.first && second == other.second &&
+             operation == other.operation;
+    }
+  };
+
+  struct MemoKeyHash {
+    std::size_t operator()(const MemoKey &key) const noexcept {
+      return detail::mixCapsHash(
+          reinterpret_cast<std::uintptr_t>(key.first) * 31U +
+          reinterpret_cast<std::uintptr_t>(key.second) +
+          static_cast<std::size_t>(key.operation));
+    }
+  };
+
+  struct MemoEntry {
+    MemoKey key;
+    // The operands are kept alive, so their addresses can't be reused by
+    // other caps while the entry exists
+    GstInternedCaps first;
+    GstInternedCaps second;
+    GstInternedCaps result;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::size_t, std::vector<GstPtr<GstCaps>>> interned;
+    std::list<MemoEntry> memoLru; // most recently used first
+    std::unordered_map<MemoKey, std::list<MemoEntry>::iterator, MemoKeyHash>
+        memoIndex;
+  };
+
+  Shard &shardFor(std::size_t hash) noexcept {
+    return m_shards[detail::mixCapsHash(hash) % SHARDS];
+  }
+
+  template <typename Compute>
+  GstInternedCaps memoized(Operation operation, const GstInternedCaps &first,
+                           const GstInternedCaps &second, Compute compute) {
+    const MemoKey key{first.self(), second.self(), operation};
+    Shard &shard = shardFor(MemoKeyHash{}(key));
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto found = shard.memoIndex.find(key);
+      if (found != shard.memoIndex.end()) {
+        shard.memoLru.splice(shard.memoLru.begin(), shard.memoLru,
+                             found->second);
+        m_memoHits.fetch_add(1, std::memory_order_relaxed);
+        return found->second->result;
+      }
+    }
+    m_memoMisses.fetch_add(1, std::memory_order_relaxed);
+
+    // Computed without the lock: it may take long, and it interns the result
+    // (which can lock this same shard).
+    GstInternedCaps result = compute();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.memoIndex.find(key) == shard.memoIndex.end()) {
+      shard.memoLru.push_front(MemoEntry{key, first, second, result});
+      shard.memoIndex.emplace(key, shard.memoLru.begin());
+      if (shard.memoLru.size() > m_memoCapacityPerShard) {
+        shard.memoIndex.erase(shard.memoLru.back().key);
+        shard.memoLru.pop_back();
+      }
+    }
+    return result;
+  }
+
+  const std::size_t m_memoCapacityPerShard;
+  std::array<Shard, SHARDS> m_shards;
+  std::atomic<std::uint64_t> m_internHits{0};
+  std::atomic<std::uint64_t> m_internMisses{0};
+  std::atomic<std::uint64_t> m_memoHits{0};
+  std::atomic<std::uint64_t> m_memoMisses{0};
+};
@@ -0,0 +1,320 @@
+/*
+ *  GstIteratorRange<Type> walks a GstIterator as a C++ input range.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+Walking the children of a bin, or the pads of an element, needs a loop over
+gst_iterator_next() that unboxes a GValue and handles GST_ITERATOR_RESYNC.
+GstIteratorRange does it, and can be used with a range-based for or any
+algorithm taking input iterators:
+
+ for (GstPtrView<GstElement> element : iterateRecurse(pipeline)) {
+   g_object_set(element.self(), ...);       // borrowed, no ref taken
+ }
+
+ auto range = iterateSrcPads(element);
+ auto found = std::find_if(range.begin(), range.end(), isLinked);
+ GstPtr<GstPad> pad = (*found).owned();     // a ref, only when needed
+
+- Elements are yielded as GstPtrView: they are only valid until the next
+  step. owned() takes a reference to keep them.
+- Iterating doesn't allocate: the GValue holding the current element lives in
+  the range.
+- If the collection changes while iterating (GST_ITERATOR_RESYNC), the
+  iterator is resynced and iteration restarts from the beginning, like
+  gst_iterator_foreach() does, so an element may be visited twice.
+  resyncs() tells how many times that happened.
+- GST_ITERATOR_ERROR throws std::runtime_error.
+
+For very large bins, forEachParallel() takes a reference to every element and
+calls a function for each of them on several threads:
+
+ forEachParallel(iterateRecurse(pipeline), [](GstPtrView<GstElement> e) {...});
+
+GstIterator is mapped for GstPtr<GstIterator>. It has no ref function
+(gst_iterator_copy() is a real copy), so GstPtr<GstIterator> can only be moved.
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace detail {
+struct IGstIterator {
+  template <typename T> static void unref(T *ptr) noexcept {
+    gst_iterator_free(ptr);
+  }
+};
+GST_PTR_MAP_INTERFACE_WITH_TYPE(GstIterator, GST_TYPE_ITERATOR)
+} // namespace detail
+
+/// Input range over the objects of a GstIterator
+/// @tparam Item is the type of the yielded objects (i.e. GstElement, GstPad)
+template <typename Item> class GstIteratorRange {
+
+  static_assert(
+      std::is_base_of_v<detail::IGObject,
+                        typename detail::GetInterface<Item>::type>,
+      "GstIteratorRange only yields GObjects");
+
+public:
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = GstPtrView<Item>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = GstPtrView<Item>;
+
+    iterator() noexcept = default;
+
+    reference operator*() const noexcept { return m_range->current(); }
+
+    iterator &operator++() {
+      m_range->advance();
+      if (m_range->m_done) {
+        m_range = nullptr;
+      }
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    bool operator==(const iterator &other) const noexcept {
+      return m_range == other.m_range;
+    }
+    bool operator!=(const iterator &other) const noexcept {
+      return m_range != other.m_range;
+    }
+
+  private:
+    friend class GstIteratorRange;
+    explicit iterator(GstIteratorRange *range) noexcept : m_range(range) {}
+
+    GstIteratorRange *m_range = nullptr;
+  };
+
+  /// Takes ownership of \p iterator
+  explicit GstIteratorRange(GstPtr<GstIterator> &&iterator) noexcept
+      : m_iterator(std::move(iterator)), m_done(!m_iterator) {}
+
+  GstIteratorRange(GstIteratorRange &&other) noexcept
+      : m_iterator(std::move(other.m_iterator)), m_value(other.m_value),
+        m_started(other.m_started), m_done(other.m_done),
+        m_resyncs(other.m_resyncs) {
+    other.m_value = G_VALUE_INIT;
+    other.m_done = true;
+  }
+  GstIteratorRange &operator=(GstIteratorRange &&) = delete;
+  GstIteratorRange(const GstIteratorRange &) = delete;
+  GstIteratorRange &operator=(const GstIteratorRange &) = delete;
+
+  ~GstIteratorRange() {
+    if (G_IS_VALUE(&m_value)) {
+      g_value_unset(&m_value);
+    }
+  }
+
+  /// The first call fetches the first element. Being an input range, later
+  /// calls return the current position.
+  /// @throws std::runtime_error on GST_ITERATOR_ERROR
+  [[nodiscard]] iterator begin() {
+    if (!m_started) {
+      m_started = true;
+      advance();
+    }
+    return m_done ? iterator{} : iterator{this};
+  }
+  [[nodiscard]] iterator end() const noexcept { return {}; }
+
+  /// Times the iteration restarted because the collection changed
+  [[nodiscard]] unsigned resyncs() const noexcept { return m_resyncs; }
+
+  /// The wrapped GstIterator
+  [[nodiscard]] GstIterator *self() const noexcept { return m_iterator.self(); }
+
+private:
+  [[nodiscard]] GstPtrView<Item> current() const noexcept {
+    return static_cast<Item *>(g_value_get_object(&m_value));
+  }
+
+  void advance() {
+    if (m_done) {
+      return;
+    }
+    for (;;) {
+      if (G_IS_VALUE(&m_value)) {
+        g_value_reset(&m_value);
+      }
+      switch (gst_iterator_next(m_iterator.self(), &m_value)) {
+      case GST_ITERATOR_OK:
+        return;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync(m_iterator.self());
+        ++m_resyncs;
+        break;
+      case GST_ITERATOR_DONE:
+        m_done = true;
+        return;
+      default:
+        m_done = true;
+        throw std::runtime_error("GstIteratorRange: iterator error");
+      }
+    }
+  }
+
+  GstPtr<GstIterator> m_iterator;
+  GValue m_value = G_VALUE_INIT;
+  bool m_started = false;
+  bool m_done;
+  unsigned m_resyncs = 0;
+};
+
+/// Direct children of \p bin
+template <typename Bin>
+[[nodiscard]] GstIteratorRange<GstElement> iterateElements(const GstPtr<Bin> &bin) {
+  return GstIteratorRange<GstElement>{
+      gst_bin_iterate_elements(bin.template self<GstBin>())};
+}
+
+/// Children of \p bin and of its child bins, recursively
+template <typename Bin>
+[[nodiscard]] GstIteratorRange<GstElement> iterateRecurse(const GstPtr<Bin> &bin) {
+  return GstIteratorRange<GstElement>{
+      gst_bin_iterate_recurse(bin.template self<GstBin>())};
+}
+
+/// Sink elements of \p bin
+template <typename Bin>
+[[nodiscard]] GstIteratorRange<GstElement> iterateSinks(const GstPtr<Bin> &bin) {
+  return GstIteratorRange<GstElement>{
+      gst_bin_iterate_sinks(bin.template self<GstBin>())};
+}
+
+/// Source elements of \p bin
+template <typename Bin>
+[[nodiscard]] GstIteratorRange<GstElement> iterateSources(const GstPtr<Bin> &bin) {
+  return GstIteratorRange<GstElement>{
+      gst_bin_iterate_sources(bin.template self<GstBin>())};
+}
+
+/// All the pads of \p element
+template <typename Element>
+[[nodiscard]] GstIteratorRange<GstPad> iteratePads(const GstPtr<Element> &element) {
+  return GstIteratorRange<GstPad>{
+      gst_element_iterate_pads(element.template self<GstElement>())};
+}
+
+/// Sink pads of \p element
+template <typename Element>
+[[nodiscard]] GstIteratorRange<GstPad>
+iterateSinkPads(const GstPtr<Element> &element) {
+  return GstIteratorRange<GstPad>{
+      gst_element_iterate_sink_pads(element.template self<GstElement>())};
+}
+
+/// Source pads of \p element
+template <typename Element>
+[[nodiscard]] GstIteratorRange<GstPad>
+iterateSrcPads(const GstPtr<Element> &element) {
+  return GstIteratorRange<GstPad>{
+      gst_element_iterate_src_pads(element.template self<GstElement>())};
+}
+
+/// Calls \p function(GstPtrView<Item>) for every element of \p range, on up to
+/// \p threads threads (the calling one included; 0 means one per core).
+/// A reference to every element is taken first, so the range is walked once
+/// and the collection may change meanwhile. Small ranges run on the calling
+/// thread. \p function must be safe to call concurrently.
+/// @throws The first exception thrown by \p function, after all threads end,
+/// or std::system_error if a thread can't be created
+template <typename Item, typename Function>
+void forEachParallel(GstIteratorRange<Item> &&range, Function function,
+                     unsigned threads = 0) {
+  constexpr std::size_t MIN_ITEMS_PER_THREAD = 16;
+
+  std::vector<GstPtr<Item>> items;
+  for (GstPtrView<Item> item : range) {
+    items.push_back(item.owned());
+  }
+
+  if (threads == 0) {
+    threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  threads = static_cast<unsigned>(std::min<std::size_t>(
+      threads, std::max<std::size_t>(1, items.size() / MIN_ITEMS_PER_THREAD)));
+  if (threads == 1) {
+    for (const auto &item : items) {
+      function(GstPtrView<Item>{item});
+    }
+    return;
+  }
+
+  // Workers grab small chunks, so uneven per-element costs are balanced
+  const std::size_t chunk =
+      std::max<std::size_t>(1, items.size() / (std::size_t{threads} * 8));
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex errorMutex;
+
+  const auto work = [&]() {
+    for (;;) {
+      const std::size_t first = next.fetch_add(chunk);
+      if (first >= items.size() || failed.load(std::memory_order_relaxed)) {
+        return;
+      }
+      const std::size_t last = std::min(first + chunk, items.size());
+      try {
+        for (std::size_t index = first; index < last; ++index) {
+          function(GstPtrView<Item>{items[index]});
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        failed = true;
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  try {
+    for (unsigned worker = 1; worker < threads; ++worker) {
+      workers.emplace_back(work);
+    }
+  } catch (...) {
+    // A thread couldn't be created (std::system_error): the started ones
+    // must be joined, or destroying them would terminate the process
+    failed = true;
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    throw;
+  }
+  work();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,143 @@
+/*
+ *  GstSharedRef/GstLocalRef share an object among threads with a reference
+ *  per thread instead of a reference per use.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+Copying a GstPtr is an atomic increment (and a decrement later) on the
+object's refcount. When many threads copy the same GstPtr<GstCaps> for every
+operation, they all write the same cache line, and throughput drops as cores
+are added.
+
+GstSharedRef holds the shared object. Each thread creates a GstLocalRef from
+it, which takes one real reference, and then gets borrowed views for free:
+
+ GstSharedRef<GstCaps> sharedCaps{caps};
+
+ // In every worker thread
+ GstLocalRef<GstCaps> caps{sharedCaps};      // one ref for this thread
+ for (...) {
+   GstPtrView<GstCaps> view = caps.get();    // no refcount access
+   ...
+ }
+
+Replacing the object starts a new epoch. The old object is released by each
+thread, on its next get(), when it picks up the new one:
+
+ sharedCaps.publish(newCaps);
+
+ - get() only reads the epoch counter (shared, but never written while the
+   object doesn't change), so the refcount is touched O(threads) times per
+   epoch rather than O(operations).
+ - A view returned by get() is valid until the next get(), release() or the
+   destruction of the GstLocalRef.
+ - release() drops the thread's reference explicitly (e.g. before a worker
+   goes idle); the next get() takes a new one.
+ - GstLocalRef is meant to be used by a single thread. GstSharedRef must
+   outlive its GstLocalRefs.
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+template <typename Type> class GstLocalRef;
+
+/// An object shared among threads through GstLocalRef<Type>
+template <typename Type> class GstSharedRef {
+public:
+  explicit GstSharedRef(GstPtr<Type> object) : m_object(std::move(object)) {}
+
+  GstSharedRef(const GstSharedRef &) = delete;
+  GstSharedRef &operator=(const GstSharedRef &) = delete;
+
+  /// Replaces the shared object, starting a new epoch
+  void publish(GstPtr<Type> object) {
+    GstPtr<Type> previous;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      previous = std::move(m_object);
+      m_object = std::move(object);
+      m_epoch.fetch_add(1, std::memory_order_release);
+    }
+    // previous is unref'ed out of the lock
+  }
+
+  /// A new reference to the current object
+  [[nodiscard]] GstPtr<Type> get() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_object;
+  }
+
+  /// Number of publish() calls so far
+  [[nodiscard]] std::uint64_t epoch() const noexcept {
+    return m_epoch.load(std::memory_order_acquire);
+  }
+
+private:
+  friend class GstLocalRef<Type>;
+
+  mutable std::mutex m_mutex;
+  GstPtr<Type> m_object;
+  // On its own cache line: it's read on every GstLocalRef::get()
+  alignas(64) std::atomic<std::uint64_t> m_epoch{0};
+};
+
+/// A thread's reference to the object of a GstSharedRef<Type>
+template <typename Type> class GstLocalRef {
+public:
+  explicit GstLocalRef(const GstSharedRef<Type> &shared) : m_shared(&shared) {
+    refresh();
+  }
+
+  GstLocalRef(GstLocalRef &&other) noexcept
+      : m_shared(other.m_shared), m_object(std::move(other.m_object)),
+        m_epoch(other.m_epoch) {}
+  GstLocalRef &operator=(GstLocalRef &&) = delete;
+  GstLocalRef(const GstLocalRef &) = delete;
+  GstLocalRef &operator=(const GstLocalRef &) = delete;
+
+  /// A view of the current object. Takes a reference only the first time,
+  /// after release(), or when a new object has been published.
+  [[nodiscard]] GstPtrView<Type> get() {
+    if (!m_object ||
+        m_shared->m_epoch.load(std::memory_order_acquire) != m_epoch) {
+      refresh();
+    }
+    return m_object;
+  }
+
+  /// Drops this thread's reference
+  void release() noexcept { m_object = GstPtr<Type>{}; }
+
+  /// Returns true if get() will return the current object without refreshing
+  [[nodiscard]] bool isCurrent() const noexcept {
+    return m_object &&
+           m_shared->m_epoch.load(std::memory_order_acquire) == m_epoch;
+  }
+
+private:
+  void refresh() {
+    GstPtr<Type> previous = std::move(m_object);
+    {
+      std::lock_guard<std::mutex> lock(m_shared->m_mutex);
+      m_object = m_shared->m_object;
+      m_epoch = m_shared->m_epoch.load(std::memory_order_relaxed);
+    }
+    // previous is unref'ed out of the lock
+  }
+
+  const GstSharedRef<Type> *m_shared;
+  GstPtr<Type> m_object;
+  std::uint64_t m_epoch = 0;
+};
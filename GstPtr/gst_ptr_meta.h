@@ -0,0 +1,281 @@
+/*
+ *  GstCustomMeta<Type> registers a C++ struct as a GstMeta.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+Registering a GstMeta needs an API type, a GstMetaInfo and init/free/transform
+functions. GstCustomMeta<Type> generates all of them from a C++ struct, whose
+only requirement is a name:
+
+ struct DetectionsMeta {
+   static constexpr const char *metaName = "MyAppDetectionsMeta";
+   std::array<Box, 16> boxes;
+   std::size_t count = 0;
+ };
+
+ DetectionsMeta *added = addMeta<DetectionsMeta>(buffer);   // writable buffer
+ DetectionsMeta *found = getMeta<DetectionsMeta>(buffer);   // nullptr if none
+ for (DetectionsMeta &meta : iterateMeta<DetectionsMeta>(buffer)) { ... }
+
+- The struct is stored inline in the GstMeta, right after its header, in the
+  same allocation GStreamer does for any meta: no extra heap allocation.
+- addMeta() forwards its extra arguments to the struct's constructor, and the
+  destructor runs when the meta is freed. Adding the meta without addMeta()
+  (i.e. gst_buffer_add_meta() from C) default-constructs the struct, or fails
+  if it has no default constructor.
+- The struct must not be over-aligned (alignof <= alignof(std::max_align_t)).
+- Registration happens on first use, and is thread-safe.
+
+What happens when GStreamer transforms a buffer (i.e. gst_buffer_copy) is
+decided by `static constexpr GstMetaCopyPolicy copyPolicy`, if the struct has
+it. By default copy-constructible structs are copied into full copies of the
+buffer (fullCopy), and other structs are dropped (never).
+
+Buffers are accessed through GstPtr<GstBuffer>, without adding any ref. The
+returned pointers are valid while the buffer holds the meta.
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// How a custom meta behaves when its buffer is copied
+enum class GstMetaCopyPolicy {
+  never,    ///< The meta is dropped
+  fullCopy, ///< Copied into full copies of the buffer, dropped on region copies
+  anyCopy   ///< Copied into any copy, including region copies
+};
+
+namespace detail {
+
+template <typename T, typename = void> struct MetaCopyPolicyOf {
+  static constexpr GstMetaCopyPolicy value =
+      std::is_copy_constructible_v<T> ? GstMetaCopyPolicy::fullCopy
+                                      : GstMetaCopyPolicy::never;
+};
+
+template <typename T>
+struct MetaCopyPolicyOf<T, std::void_t<decltype(T::copyPolicy)>> {
+  static constexpr GstMetaCopyPolicy value = T::copyPolicy;
+};
+
+// Passed as the `params` of gst_buffer_add_meta(), so the struct is constructed
+// directly in the meta storage. Exceptions are carried back to addMeta().
+struct MetaConstructor {
+  void (*construct)(void *storage, void *arguments);
+  void *arguments;
+  std::exception_ptr error;
+};
+
+} // namespace detail
+
+/// Registration and layout of a C++ struct used as a GstMeta
+/// @tparam Data is the struct. It needs a `static constexpr const char
+/// *metaName`, which must be a valid and unique GType name.
+template <typename Data> class GstCustomMeta {
+
+  static_assert(alignof(Data) <= alignof(std::max_align_t),
+                "So sorry! Over-aligned types can't be stored in a GstMeta");
+
+public:
+  /// Offset of the struct from the start of the GstMeta
+  static constexpr std::size_t DATA_OFFSET =
+      (sizeof(GstMeta) + alignof(Data) - 1) / alignof(Data) * alignof(Data);
+
+  /// The registered API type
+  [[nodiscard]] static GType apiType() {
+    static const GType type = [] {
+      static const gchar *tags[] = {nullptr};
+      const std::string apiName = std::string(Data::metaName) + "API";
+      return gst_meta_api_type_register(apiName.c_str(), tags);
+    }();
+    return type;
+  }
+
+  /// The registered implementation
+  [[nodiscard]] static const GstMetaInfo *info() {
+    static const GstMetaInfo *metaInfo = gst_meta_register(
+        apiType(), Data::metaName, DATA_OFFSET + sizeof(Data), &initData,
+        &freeData, &transformData);
+    return metaInfo;
+  }
+
+  /// The struct stored in \p meta, which must be of this implementation
+  [[nodiscard]] static Data *data(GstMeta *meta) noexcept {
+    return std::launder(
+        reinterpret_cast<Data *>(reinterpret_cast<char *>(meta) + DATA_OFFSET));
+  }
+
+private:
+  static gboolean initData(GstMeta *meta, gpointer params, GstBuffer *) noexcept {
+    void *storage = reinterpret_cast<char *>(meta) + DATA_OFFSET;
+    auto *constructor = static_cast<detail::MetaConstructor *>(params);
+    try {
+      if (constructor != nullptr) {
+        constructor->construct(storage, constructor->arguments);
+      } else if constexpr (std::is_default_constructible_v<Data>) {
+        new (storage) Data();
+      } else {
+        // Added without arguments (i.e. from C), and it needs some
+        return FALSE;
+      }
+    } catch (...) {
+      if (constructor != nullptr) {
+        constructor->error = std::current_exception();
+      }
+      // GStreamer releases the meta without calling free()
+      return FALSE;
+    }
+    return TRUE;
+  }
+
+  static void freeData(GstMeta *meta, GstBuffer *) noexcept {
+    data(meta)->~Data();
+  }
+
+  static gboolean transformData(GstBuffer *destination, GstMeta *meta,
+                                GstBuffer *, GQuark type,
+                                gpointer params) noexcept {
+    constexpr GstMetaCopyPolicy policy = detail::MetaCopyPolicyOf<Data>::value;
+    if constexpr (policy == GstMetaCopyPolicy::never) {
+      return FALSE;
+    } else {
+      if (!GST_META_TRANSFORM_IS_COPY(type)) {
+        return FALSE;
+      }
+      const auto *copy = static_cast<GstMetaTransformCopy *>(params);
+      if (policy == GstMetaCopyPolicy::fullCopy && copy->region != FALSE) {
+        return FALSE;
+      }
+      detail::MetaConstructor constructor{
+          [](void *storage, void *source) {
+            new (storage) Data(*static_cast<const Data *>(source));
+          },
+          data(meta), nullptr};
+      return gst_buffer_add_meta(destination, info(), &constructor) != nullptr
+                 ? TRUE
+                 : FALSE;
+    }
+  }
+};
+
+/// Adds a \p Data meta to \p buffer, constructing it from \p arguments.
+/// @return The stored struct, or nullptr if the buffer isn't writable
+/// @throws whatever the \p Data constructor throws
+template <typename Data, typename... Args>
+Data *addMeta(const GstPtr<GstBuffer> &buffer, Args &&...arguments) {
+  auto forwarded = std::forward_as_tuple(std::forward<Args>(arguments)...);
+  detail::MetaConstructor constructor{
+      [](void *storage, void *context) {
+        std::apply(
+            [storage](auto &&...values) {
+              new (storage) Data(std::forward<decltype(values)>(values)...);
+            },
+            std::move(*static_cast<decltype(forwarded) *>(context)));
+      },
+      &forwarded, nullptr};
+  GstMeta *meta = gst_buffer_add_meta(buffer.self(),
+                                      GstCustomMeta<Data>::info(), &constructor);
+  if (constructor.error) {
+    std::rethrow_exception(constructor.error);
+  }
+  return meta != nullptr ? GstCustomMeta<Data>::data(meta) : nullptr;
+}
+
+/// The first \p Data meta of \p buffer
+/// @return nullptr if there's none
+template <typename Data>
+[[nodiscard]] Data *getMeta(const GstPtr<GstBuffer> &buffer) {
+  GstMeta *meta =
+      gst_buffer_get_meta(buffer.self(), GstCustomMeta<Data>::apiType());
+  return meta != nullptr ? GstCustomMeta<Data>::data(meta) : nullptr;
+}
+
+/// Removes the first \p Data meta of \p buffer, which must be writable
+/// @return false if there's none
+template <typename Data> bool removeMeta(const GstPtr<GstBuffer> &buffer) {
+  GstMeta *meta =
+      gst_buffer_get_meta(buffer.self(), GstCustomMeta<Data>::apiType());
+  return meta != nullptr &&
+         gst_buffer_remove_meta(buffer.self(), meta) != FALSE;
+}
+
+/// Input range over every \p Data meta of a buffer. See iterateMeta().
+template <typename Data> class GstMetaRange {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Data;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Data *;
+    using reference = Data &;
+
+    iterator() noexcept = default;
+
+    reference operator*() const noexcept {
+      return *GstCustomMeta<Data>::data(m_meta);
+    }
+    pointer operator->() const noexcept {
+      return GstCustomMeta<Data>::data(m_meta);
+    }
+    iterator &operator++() noexcept {
+      m_meta = gst_buffer_iterate_meta_filtered(m_buffer, &m_state, m_api);
+      return *this;
+    }
+    void operator++(int) noexcept { ++*this; }
+
+    friend bool operator==(const iterator &lhs, const iterator &rhs) noexcept {
+      return lhs.m_meta == rhs.m_meta;
+    }
+    friend bool operator!=(const iterator &lhs, const iterator &rhs) noexcept {
+      return lhs.m_meta != rhs.m_meta;
+    }
+
+  private:
+    friend class GstMetaRange;
+    iterator(GstBuffer *buffer, GType api) noexcept
+        : m_buffer(buffer), m_api(api) {
+      ++*this;
+    }
+
+    GstBuffer *m_buffer = nullptr;
+    gpointer m_state = nullptr;
+    GType m_api = G_TYPE_INVALID;
+    GstMeta *m_meta = nullptr;
+  };
+
+  explicit GstMetaRange(GstBuffer *buffer) : m_buffer(buffer) {}
+
+  [[nodiscard]] iterator begin() const {
+    return m_buffer != nullptr
+               ? iterator{m_buffer, GstCustomMeta<Data>::apiType()}
+               : iterator{};
+  }
+  [[nodiscard]] iterator end() const noexcept { return {}; }
+
+private:
+  GstBuffer *m_buffer;
+};
+
+/// Iterates over every \p Data meta of \p buffer, in the order they were added.
+/// @note Don't add or remove metas while iterating.
+template <typename Data>
+[[nodiscard]] GstMetaRange<Data>
+iterateMeta(const GstPtr<GstBuffer> &buffer) {
+  return GstMetaRange<Data>{buffer.self()};
+}
@@ -0,0 +1,230 @@
+/*
+ *  GstProperty<Type> is a typed, pre-resolved handle to a GObject property.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+g_object_set()/g_object_get() parse a varargs list and look the GParamSpec up
+by name (under the class lock) on every single call. That's fine for setting
+up a pipeline, but not for a controller that updates a property hundreds of
+times per second.
+
+GstProperty<Type> does the lookup once, when it is constructed:
+
+ GstPtr<GstElement> encoder = gst_element_factory_make("x264enc", nullptr);
+ encoder.sink();
+
+ GstProperty<guint> bitrate{encoder, "bitrate"};   // pspec lookup + type check
+ bitrate.set(4000);                                // no lookup, no varargs
+ guint current = bitrate.get();
+
+The handle keeps a reference to the object and to its GParamSpec, and owns a
+preallocated GValue of the property type that is reused by every set/get.
+Because of that GValue, a handle is NOT thread-safe: use one handle per thread.
+
+set() behaves like g_object_set_property(): values the GParamSpec rejects (i.e.
+out of range) are not written, but reported with std::invalid_argument instead
+of a warning, unless the pspec has G_PARAM_LAX_VALIDATION (then they are
+clamped). "notify" is only emitted for readable properties, and the ones
+emitted by the object while the property is set are queued until it ends.
+
+Construction throws std::invalid_argument if the property doesn't exist or if
+its type can't be held by Type. Supported Types:
+
+ +---------------------------+--------------------------------------------+
+ | Type                      | Property type                              |
+ +---------------------------+--------------------------------------------+
+ | bool                      | G_TYPE_BOOLEAN                             |
+ | gint                      | G_TYPE_INT, any G_TYPE_ENUM                |
+ | guint                     | G_TYPE_UINT, any G_TYPE_FLAGS              |
+ | gint64 / guint64          | G_TYPE_INT64 / G_TYPE_UINT64               |
+ | gfloat / gdouble          | G_TYPE_FLOAT / G_TYPE_DOUBLE               |
+ | std::string               | G_TYPE_STRING                              |
+ | const gchar*              | G_TYPE_STRING, valid until the next get()  |
+ | any C++ enum (GstState..) | any G_TYPE_ENUM                            |
+ +---------------------------+--------------------------------------------+
+
+Several updates on the same object can be batched, so "notify" is emitted
+once per property after the last update instead of after each one:
+
+ GstPropertyBatch{encoder}.set(bitrate, 4000).set(keyIntMax, 60);
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+#include "gst_ptr_value.h"
+
+#include <stdexcept>
+#include <string>
+
+/// Typed handle to a property of a GObject, resolved once at construction.
+/// @tparam ValueType is the C++ type used to set/get the property.
+/// @note Not thread-safe: every handle reuses its own GValue.
+template <typename ValueType> class GstProperty {
+
+  static_assert(detail::ValueTraits<ValueType>::supported,
+                "So sorry! This type can't be used as a property value. "
+                "Add a detail::ValueTraits<> specialization for it");
+
+  using Traits = detail::ValueTraits<ValueType>;
+
+public:
+  using value_type = ValueType;
+
+  /// Resolves the GParamSpec of \p name in \p object.
+  /// @throws std::invalid_argument if the property doesn't exist, or if its
+  /// type is not compatible with \p ValueType
+  template <typename ObjectType>
+  GstProperty(const GstPtr<ObjectType> &object, const gchar *name) {
+    m_object.transferNone(object.template self<GObject>());
+    if (!m_object) {
+      throw std::invalid_argument("GstProperty: null object");
+    }
+
+    GParamSpec *pspec = g_object_class_find_property(
+        G_OBJECT_GET_CLASS(m_object.self()), name);
+    if (pspec == nullptr) {
+      throw std::invalid_argument(std::string("GstProperty: no property '") +
+                                  name + "'");
+    }
+
+    // Same resolution g_object_set_property() does on every call: the class
+    // and the id come from the pspec found, but overridden properties
+    // (g_object_class_override_property) redirect to the original pspec.
+    m_class = static_cast<GObjectClass *>(g_type_class_peek(pspec->owner_type));
+    m_paramId = pspec->param_id;
+    GParamSpec *redirect = g_param_spec_get_redirect_target(pspec);
+    m_pspec.transferNone(redirect != nullptr ? redirect : pspec);
+
+    m_fundamental = G_TYPE_FUNDAMENTAL(m_pspec->value_type);
+    if (!Traits::accepts(m_fundamental)) {
+      throw std::invalid_argument(std::string("GstProperty: property '") +
+                                  name + "' holds a " +
+                                  g_type_name(m_pspec->value_type));
+    }
+    g_value_init(&m_value, m_pspec->value_type);
+  }
+
+  GstProperty(GstProperty &&other) noexcept
+      : m_object(std::move(other.m_object)), m_pspec(std::move(other.m_pspec)),
+        m_class(other.m_class), m_paramId(other.m_paramId),
+        m_fundamental(other.m_fundamental), m_value(other.m_value) {
+    // GValue contents can be moved bitwise, as long as the source is cleared
+    other.m_value = G_VALUE_INIT;
+  }
+  GstProperty &operator=(GstProperty &&) = delete;
+  GstProperty(const GstProperty &) = delete;
+  GstProperty &operator=(const GstProperty &) = delete;
+
+  ~GstProperty() {
+    if (G_IS_VALUE(&m_value)) {
+      g_value_unset(&m_value);
+    }
+  }
+
+  /// Sets the property and emits "notify", as g_object_set_property() does:
+  /// only for readable properties, and not for G_PARAM_EXPLICIT_NOTIFY ones
+  /// (the object emits it). Notifications emitted while setting the property
+  /// are queued, and emitted once each when it is set.
+  /// @throws std::logic_error if the property isn't writable
+  /// @throws std::invalid_argument if the pspec rejects the value (i.e. out of
+  /// range), which is left unchanged. G_PARAM_LAX_VALIDATION pspecs fix the
+  /// value (i.e. clamp it) instead.
+  void set(const ValueType &newValue) {
+    if ((m_pspec->flags & G_PARAM_WRITABLE) == 0 ||
+        (m_pspec->flags & G_PARAM_CONSTRUCT_ONLY) != 0) {
+      throw std::logic_error(std::string("GstProperty: '") + m_pspec->name +
+                             "' is not writable");
+    }
+    Traits::set(&m_value, m_fundamental, newValue);
+    // g_object_set_property() warns and doesn't set values the pspec had to
+    // modify, unless its validation is lax: don't write a clamped value either
+    if (g_param_value_validate(m_pspec.self(), &m_value) != FALSE &&
+        (m_pspec->flags & G_PARAM_LAX_VALIDATION) == 0) {
+      throw std::invalid_argument(
+          std::string("GstProperty: invalid value for '") + m_pspec->name +
+          "'");
+    }
+    // set_property() may notify other properties too, so queue them as
+    // g_object_set_property() does
+    g_object_freeze_notify(m_object.self());
+    m_class->set_property(m_object.self(), m_paramId, &m_value, m_pspec.self());
+    if ((m_pspec->flags & (G_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY)) ==
+        G_PARAM_READABLE) {
+      g_object_notify_by_pspec(m_object.self(), m_pspec.self());
+    }
+    g_object_thaw_notify(m_object.self());
+  }
+
+  /// Reads the current value of the property.
+  /// @throws std::logic_error if the property isn't readable
+  [[nodiscard]] ValueType get() {
+    if ((m_pspec->flags & G_PARAM_READABLE) == 0) {
+      throw std::logic_error(std::string("GstProperty: '") + m_pspec->name +
+                             "' is not readable");
+    }
+    g_value_reset(&m_value);
+    m_class->get_property(m_object.self(), m_paramId, &m_value, m_pspec.self());
+    return Traits::get(&m_value, m_fundamental);
+  }
+
+  /// The resolved GParamSpec, i.e. for reading its range or default value.
+  [[nodiscard]] GParamSpec *pspec() const noexcept { return m_pspec.self(); }
+
+  /// The object this handle operates on.
+  [[nodiscard]] GObject *object() const noexcept { return m_object.self(); }
+
+private:
+  GstPtr<GObject> m_object;
+  GstPtr<GParamSpec> m_pspec;
+  GObjectClass *m_class = nullptr;
+  guint m_paramId = 0;
+  GType m_fundamental = G_TYPE_NONE;
+  GValue m_value = G_VALUE_INIT;
+};
+
+/// Freezes "notify" emission on an object while several properties are set.
+/// Queued notifications are emitted once, when the batch is destroyed.
+class GstPropertyBatch {
+public:
+  template <typename ObjectType>
+  explicit GstPropertyBatch(const GstPtr<ObjectType> &object) {
+    m_object.transferNone(object.template self<GObject>());
+    if (m_object) {
+      g_object_freeze_notify(m_object.self());
+    }
+  }
+
+  GstPropertyBatch(const GstPropertyBatch &) = delete;
+  GstPropertyBatch &operator=(const GstPropertyBatch &) = delete;
+
+  ~GstPropertyBatch() {
+    if (m_object) {
+      g_object_thaw_notify(m_object.self());
+    }
+  }
+
+  /// Sets \p property of the batched object.
+  /// @throws std::invalid_argument if \p property belongs to another object,
+  /// whose notifications wouldn't be batched
+  template <typename ValueType>
+  GstPropertyBatch &
+  set(GstProperty<ValueType> &property,
+      const typename GstProperty<ValueType>::value_type &newValue) {
+    if (property.object() != m_object.self()) {
+      throw std::invalid_argument(
+          std::string("GstPropertyBatch: '") + property.pspec()->name +
+          "' belongs to another object");
+    }
+    property.set(newValue);
+    return *this;
+  }
+
+private:
+  GstPtr<GObject> m_object;
+};
@@ -0,0 +1,240 @@
+/*
+ *  GstField<Type> is a typed GstStructure field descriptor with a cached GQuark.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+gst_structure_get_int(s, "width", &width) interns "width" (a global hash
+lookup) every single time before searching the field. GstField<Type> interns
+the name once, the first time it is used, and then reads/writes the field
+with the gst_structure_id_* API:
+
+ inline const GstField<gint> widthField{"width"};
+ inline const GstField<GstFieldFraction> framerateField{"framerate"};
+
+ const GstStructure *s = borrowStructure(caps);        // no extra ref
+ std::optional<gint> width = widthField.get(s);        // nullopt if missing
+                                                       // or of another type
+ widthField.set(writableStructure, 1920);
+
+Several fields can be read with a single walk over the structure:
+
+ auto [width, height, framerate] =
+     readFields(s, widthField, heightField, framerateField);
+
+Supported Types: the ones of detail::ValueTraits (gst_ptr_value.h), where
+const gchar* is borrowed from the structure, and GstFieldFraction. gint also
+reads enum fields and guint flags fields. Enum descriptors need the registered
+GType, which set() stores:
+
+ inline const GstField<GstState> newStateField{"new-state", GST_TYPE_STATE};
+
+Descriptors are cheap and thread-safe; declare them once (namespace scope or
+static) and reuse them.
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+#include "gst_ptr_value.h"
+
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// Value of a GST_TYPE_FRACTION field (i.e. "framerate")
+struct GstFieldFraction {
+  gint numerator = 0;
+  gint denominator = 1;
+};
+
+namespace detail {
+
+template <> struct ValueTraits<GstFieldFraction> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return GST_TYPE_FRACTION; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == GST_TYPE_FRACTION;
+  }
+  static void set(GValue *value, GType, GstFieldFraction newValue) noexcept {
+    gst_value_set_fraction(value, newValue.numerator, newValue.denominator);
+  }
+  static GstFieldFraction get(const GValue *value, GType) noexcept {
+    return {gst_value_get_fraction_numerator(value),
+            gst_value_get_fraction_denominator(value)};
+  }
+};
+
+} // namespace detail
+
+/// Typed descriptor of a GstStructure field, with its name interned once.
+/// @tparam ValueType is the C++ type of the field
+template <typename ValueType> class GstField {
+
+  static_assert(detail::ValueTraits<ValueType>::supported,
+                "So sorry! This type can't be used as a field value. "
+                "Add a detail::ValueTraits<> specialization for it");
+
+  using Traits = detail::ValueTraits<ValueType>;
+
+public:
+  using value_type = ValueType;
+
+  /// @param name must outlive the descriptor (i.e. a string literal)
+  constexpr explicit GstField(const gchar *name) noexcept : m_name(name) {
+    static_assert(!std::is_enum_v<ValueType>,
+                  "Enum fields are stored with their registered GType, "
+                  "use GstField<Enum>{name, enumType}");
+  }
+
+  /// Descriptor of an enum field.
+  /// @param name must outlive the descriptor (i.e. a string literal)
+  /// @param enumType the registered GType of \p ValueType, used by set()
+  constexpr GstField(const gchar *name, GType enumType) noexcept
+      : m_name(name), m_enumType(enumType) {
+    static_assert(std::is_enum_v<ValueType>,
+                  "Only enum fields need a GType, use GstField<Type>{name}");
+  }
+
+  GstField(const GstField &) = delete;
+  GstField &operator=(const GstField &) = delete;
+
+  /// The interned field name. Interning happens only on the first call.
+  [[nodiscard]] GQuark quark() const noexcept {
+    GQuark quark = m_quark.load(std::memory_order_relaxed);
+    if (G_UNLIKELY(quark == 0)) {
+      // Racing threads get the same quark, so a plain store is enough
+      quark = g_quark_from_static_string(m_name);
+      m_quark.store(quark, std::memory_order_relaxed);
+    }
+    return quark;
+  }
+
+  [[nodiscard]] const gchar *name() const noexcept { return m_name; }
+
+  /// Reads the field.
+  /// @return std::nullopt if the field is missing or holds another type
+  [[nodiscard]] std::optional<ValueType>
+  get(const GstStructure *structure) const noexcept {
+    return fromValue(gst_structure_id_get_value(structure, quark()));
+  }
+
+  /// Converts a field value found by other means (i.e. readFields())
+  [[nodiscard]] static std::optional<ValueType>
+  fromValue(const GValue *value) noexcept {
+    if (value == nullptr) {
+      return std::nullopt;
+    }
+    const GType fundamental = G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(value));
+    if (!Traits::accepts(fundamental)) {
+      return std::nullopt;
+    }
+    return Traits::get(value, fundamental);
+  }
+
+  /// Writes the field, replacing any previous value.
+  /// @note \p structure must be writable (i.e. from gst_caps_make_writable)
+  /// @throws std::invalid_argument for enum fields whose GType isn't an enum
+  /// (i.e. G_TYPE_INVALID), leaving the structure unchanged
+  void set(GstStructure *structure, ValueType newValue) const
+      noexcept(!std::is_enum_v<ValueType>) {
+    const GType type = valueType();
+    if constexpr (std::is_enum_v<ValueType>) {
+      if (G_TYPE_FUNDAMENTAL(type) != G_TYPE_ENUM) {
+        throw std::invalid_argument(std::string("GstField: '") + m_name +
+                                    "' has no enum GType");
+      }
+    }
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, type);
+    Traits::set(&value, G_TYPE_FUNDAMENTAL(type), newValue);
+    gst_structure_id_take_value(structure, quark(), &value);
+  }
+
+  /// Returns true if the field exists and holds a \p ValueType
+  [[nodiscard]] bool isIn(const GstStructure *structure) const noexcept {
+    const GValue *value = gst_structure_id_get_value(structure, quark());
+    return value != nullptr &&
+           Traits::accepts(G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(value)));
+  }
+
+private:
+  [[nodiscard]] GType valueType() const noexcept {
+    if constexpr (std::is_enum_v<ValueType>) {
+      return m_enumType;
+    } else {
+      return Traits::type();
+    }
+  }
+
+  const gchar *m_name;
+  GType m_enumType = G_TYPE_INVALID;
+  mutable std::atomic<GQuark> m_quark{0};
+};
+
+namespace detail {
+
+template <typename... ValueTypes> struct ReadFieldsContext {
+  std::tuple<const GstField<ValueTypes> &...> fields;
+  std::tuple<std::optional<ValueTypes>...> values;
+  std::size_t pending = sizeof...(ValueTypes);
+};
+
+template <std::size_t... Index, typename... ValueTypes>
+void matchField(ReadFieldsContext<ValueTypes...> &context, GQuark fieldId,
+                const GValue *value, std::index_sequence<Index...>) noexcept {
+  auto match = [&](const auto &field, auto &result) {
+    if (field.quark() == fieldId) {
+      result = field.fromValue(value);
+      --context.pending;
+    }
+  };
+  (match(std::get<Index>(context.fields), std::get<Index>(context.values)),
+   ...);
+}
+
+template <typename... ValueTypes>
+gboolean readFieldsCallback(GQuark fieldId, const GValue *value,
+                            gpointer userData) noexcept {
+  auto &context = *static_cast<ReadFieldsContext<ValueTypes...> *>(userData);
+  matchField(context, fieldId, value, std::index_sequence_for<ValueTypes...>{});
+  return context.pending != 0 ? TRUE : FALSE;
+}
+
+} // namespace detail
+
+/// Reads several fields walking the structure only once.
+/// @return A tuple with one std::optional per field, in the same order
+template <typename... ValueTypes>
+[[nodiscard]] std::tuple<std::optional<ValueTypes>...>
+readFields(const GstStructure *structure,
+           const GstField<ValueTypes> &...fields) noexcept {
+  detail::ReadFieldsContext<ValueTypes...> context{std::tie(fields...), {}};
+  // Intern up front, so the callback only compares integers
+  ((void)fields.quark(), ...);
+  gst_structure_foreach(structure,
+                        &detail::readFieldsCallback<ValueTypes...>, &context);
+  return context.values;
+}
+
+/// Borrows a structure from caps: no ref, valid while \p caps is alive and
+/// not modified.
+[[nodiscard]] inline const GstStructure *
+borrowStructure(const GstPtr<GstCaps> &caps, guint index = 0) noexcept {
+  return gst_caps_get_structure(caps.self(), index);
+}
+
+/// Borrows the structure of an event (nullptr if it has none): no ref, valid
+/// while \p event is alive.
+[[nodiscard]] inline const GstStructure *
+borrowStructure(const GstPtr<GstEvent> &event) noexcept {
+  return gst_event_get_structure(event.self());
+}
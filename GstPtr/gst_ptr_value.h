@@ -0,0 +1,204 @@
+/*
+ *  detail::ValueTraits<Type> maps C++ types to GValue contents.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17
+ *
+ */
+
+/*
+The single table used by GstProperty<Type> (gst_ptr_property.h) and
+GstField<Type> (gst_ptr_structure.h) to store a C++ value into a GValue and to
+read it back. Each specialization provides:
+
+ supported                      true
+ accepts(fundamental)           if a GValue of this fundamental GType can
+                                hold the C++ type
+ set(value, fundamental, v)     stores v into an initialized GValue
+ get(value, fundamental)        reads the GValue
+ type()                         the GType a new GValue is initialized with.
+                                Missing for C++ enums: their registered GType
+                                can't be known from the C++ type.
+
+ +---------------------------+--------------------------------------------+
+ | Type                      | Fundamental GType                          |
+ +---------------------------+--------------------------------------------+
+ | bool                      | G_TYPE_BOOLEAN                             |
+ | gint                      | G_TYPE_INT, any G_TYPE_ENUM                |
+ | guint                     | G_TYPE_UINT, any G_TYPE_FLAGS              |
+ | gint64 / guint64          | G_TYPE_INT64 / G_TYPE_UINT64               |
+ | gfloat / gdouble          | G_TYPE_FLOAT / G_TYPE_DOUBLE               |
+ | std::string               | G_TYPE_STRING (copied)                     |
+ | const gchar*              | G_TYPE_STRING (borrowed from the GValue)   |
+ | any C++ enum (GstState..) | any G_TYPE_ENUM                            |
+ +---------------------------+--------------------------------------------+
+
+Other types are added with a specialization (i.e. GstFieldFraction).
+*/
+
+#pragma once
+
+#include "gst_ptr.h"
+
+#include <string>
+#include <type_traits>
+
+namespace detail {
+
+template <typename T, typename = void> struct ValueTraits {
+  static constexpr bool supported = false;
+};
+
+template <> struct ValueTraits<bool> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_BOOLEAN; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_BOOLEAN;
+  }
+  static void set(GValue *value, GType, bool newValue) noexcept {
+    g_value_set_boolean(value, newValue ? TRUE : FALSE);
+  }
+  static bool get(const GValue *value, GType) noexcept {
+    return g_value_get_boolean(value) != FALSE;
+  }
+};
+
+template <> struct ValueTraits<gint> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_INT; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_INT || fundamental == G_TYPE_ENUM;
+  }
+  static void set(GValue *value, GType fundamental, gint newValue) noexcept {
+    if (fundamental == G_TYPE_ENUM) {
+      g_value_set_enum(value, newValue);
+    } else {
+      g_value_set_int(value, newValue);
+    }
+  }
+  static gint get(const GValue *value, GType fundamental) noexcept {
+    return fundamental == G_TYPE_ENUM ? g_value_get_enum(value)
+                                      : g_value_get_int(value);
+  }
+};
+
+template <> struct ValueTraits<guint> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_UINT; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_UINT || fundamental == G_TYPE_FLAGS;
+  }
+  static void set(GValue *value, GType fundamental, guint newValue) noexcept {
+    if (fundamental == G_TYPE_FLAGS) {
+      g_value_set_flags(value, newValue);
+    } else {
+      g_value_set_uint(value, newValue);
+    }
+  }
+  static guint get(const GValue *value, GType fundamental) noexcept {
+    return fundamental == G_TYPE_FLAGS ? g_value_get_flags(value)
+                                       : g_value_get_uint(value);
+  }
+};
+
+template <> struct ValueTraits<gint64> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_INT64; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_INT64;
+  }
+  static void set(GValue *value, GType, gint64 newValue) noexcept {
+    g_value_set_int64(value, newValue);
+  }
+  static gint64 get(const GValue *value, GType) noexcept {
+    return g_value_get_int64(value);
+  }
+};
+
+template <> struct ValueTraits<guint64> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_UINT64; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_UINT64;
+  }
+  static void set(GValue *value, GType, guint64 newValue) noexcept {
+    g_value_set_uint64(value, newValue);
+  }
+  static guint64 get(const GValue *value, GType) noexcept {
+    return g_value_get_uint64(value);
+  }
+};
+
+template <> struct ValueTraits<gfloat> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_FLOAT; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_FLOAT;
+  }
+  static void set(GValue *value, GType, gfloat newValue) noexcept {
+    g_value_set_float(value, newValue);
+  }
+  static gfloat get(const GValue *value, GType) noexcept {
+    return g_value_get_float(value);
+  }
+};
+
+template <> struct ValueTraits<gdouble> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_DOUBLE; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_DOUBLE;
+  }
+  static void set(GValue *value, GType, gdouble newValue) noexcept {
+    g_value_set_double(value, newValue);
+  }
+  static gdouble get(const GValue *value, GType) noexcept {
+    return g_value_get_double(value);
+  }
+};
+
+template <> struct ValueTraits<std::string> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_STRING; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_STRING;
+  }
+  static void set(GValue *value, GType, const std::string &newValue) noexcept {
+    g_value_set_string(value, newValue.c_str());
+  }
+  static std::string get(const GValue *value, GType) {
+    const gchar *content = g_value_get_string(value);
+    return content != nullptr ? std::string{content} : std::string{};
+  }
+};
+
+template <> struct ValueTraits<const gchar *> {
+  static constexpr bool supported = true;
+  static GType type() noexcept { return G_TYPE_STRING; }
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_STRING;
+  }
+  static void set(GValue *value, GType, const gchar *newValue) noexcept {
+    g_value_set_string(value, newValue);
+  }
+  static const gchar *get(const GValue *value, GType) noexcept {
+    return g_value_get_string(value);
+  }
+};
+
+template <typename T>
+struct ValueTraits<T, std::enable_if_t<std::is_enum_v<T>>> {
+  static constexpr bool supported = true;
+  static bool accepts(GType fundamental) noexcept {
+    return fundamental == G_TYPE_ENUM;
+  }
+  static void set(GValue *value, GType, T newValue) noexcept {
+    g_value_set_enum(value, static_cast<gint>(newValue));
+  }
+  static T get(const GValue *value, GType) noexcept {
+    return static_cast<T>(g_value_get_enum(value));
+  }
+};
+
+} // namespace detail
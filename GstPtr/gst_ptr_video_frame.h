@@ -0,0 +1,257 @@
+/*
+ *  GstMappedVideoFrame is a scoped GstVideoFrame mapping with per-plane views.
+ *  (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+ *  Licensed under the MIT License. See LICENSE file for details.
+ *
+ *  This needs C++17 and gst-video (gstreamer-video-1.0)
+ *
+ */
+
+/*
+gst_video_frame_map() gives per-plane pointers and strides, but it has to be
+paired with gst_video_frame_unmap() on every path. GstMappedVideoFrame maps on
+construction and unmaps on destruction:
+
+ GstMappedVideoFrame frame{buffer, videoInfo, GST_MAP_READ};  // may throw
+ auto luma = frame.plane<guint8>(0);
+ for (guint y = 0; y < luma.height(); ++y) {
+   const guint8 *row = luma.row(y);   // luma.width() pixels
+   ...
+ }
+
+Each GstPlaneView<Pixel> also reports what a SIMD loop needs to know:
+
+ - alignment(): the largest power of two (up to 64) both the plane start and
+   the stride are multiple of, so every row starts at least that aligned.
+ - paddedWidth(): pixels that can be touched in a row, including the padding
+   up to the stride. If it is a multiple of the vector width, the loop can run
+   whole vectors without a scalar tail.
+ - paddedRows(): rows that have that padding, all but the last one. The plane
+   may end right after the image content of its last row (i.e. with a
+   GstVideoMeta from upstream, or a GstMemory per plane), so the last row
+   must stop at width().
+
+For transforms, GstMappedVideoTransform maps input (read) and output (write)
+together, or a single read-write frame when both buffers are the same, so the
+same code serves in-place and not-in-place transforms.
+
+This header is empty unless <gst/video/video.h> can be included.
+*/
+
+#pragma once
+
+#if __has_include(<gst/video/video.h>)
+#include <gst/video/video.h>
+
+#include "gst_ptr.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+/// Contiguous pixels of a row. Iterable, i.e. with a range-based for.
+template <typename Pixel> class GstRowSpan {
+public:
+  GstRowSpan(Pixel *data, std::size_t size) noexcept
+      : m_data(data), m_size(size) {}
+
+  [[nodiscard]] Pixel *data() const noexcept { return m_data; }
+  [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+  [[nodiscard]] Pixel *begin() const noexcept { return m_data; }
+  [[nodiscard]] Pixel *end() const noexcept { return m_data + m_size; }
+  Pixel &operator[](std::size_t index) const noexcept { return m_data[index]; }
+
+private:
+  Pixel *m_data;
+  std::size_t m_size;
+};
+
+/// 2D view of a mapped plane
+/// @tparam Pixel is the unit the plane is accessed with (i.e. guint8 for I420
+/// planes, guint16 for 16 bits formats, guint32 for packed RGBA...)
+template <typename Pixel> class GstPlaneView {
+public:
+  GstPlaneView(gpointer data, guint rowBytes, guint height, gint stride) noexcept
+      : m_data(static_cast<std::uint8_t *>(data)), m_rowBytes(rowBytes),
+        m_height(height), m_stride(stride) {}
+
+  /// Pixels with image content in each row
+  [[nodiscard]] guint width() const noexcept {
+    return m_rowBytes / sizeof(Pixel);
+  }
+  [[nodiscard]] guint height() const noexcept { return m_height; }
+  /// Bytes between the start of two consecutive rows
+  [[nodiscard]] gint stride() const noexcept { return m_stride; }
+
+  /// Pixels that can be accessed in each of the first paddedRows() rows,
+  /// including the padding
+  [[nodiscard]] guint paddedWidth() const noexcept {
+    return static_cast<guint>(m_stride) / sizeof(Pixel);
+  }
+
+  /// Bytes of padding at the end of each row
+  [[nodiscard]] guint padding() const noexcept {
+    return static_cast<guint>(m_stride) - m_rowBytes;
+  }
+
+  /// Rows whose padding can be accessed: all but the last one, as the mapped
+  /// memory may end at its width()
+  [[nodiscard]] guint paddedRows() const noexcept {
+    return m_height == 0 ? 0 : m_height - 1;
+  }
+
+  /// Alignment, in bytes, guaranteed for the start of every row (max 64)
+  [[nodiscard]] std::size_t alignment() const noexcept {
+    const auto bits = reinterpret_cast<std::uintptr_t>(m_data) |
+                      static_cast<std::uintptr_t>(m_stride) | 64U;
+    return static_cast<std::size_t>(bits & (~bits + 1U));
+  }
+
+  /// Returns true if rows start \p bytes aligned and the first paddedRows()
+  /// rows can be processed in whole blocks of \p bytes (reaching into the
+  /// padding), without a tail. The last row still ends at width().
+  [[nodiscard]] bool isVectorFriendly(std::size_t bytes) const noexcept {
+    return alignment() >= bytes &&
+           static_cast<std::size_t>(m_stride) % bytes == 0;
+  }
+
+  [[nodiscard]] Pixel *row(guint y) const noexcept {
+    return reinterpret_cast<Pixel *>(m_data +
+                                     static_cast<std::ptrdiff_t>(y) * m_stride);
+  }
+
+  /// The image content of a row
+  [[nodiscard]] GstRowSpan<Pixel> rowSpan(guint y) const noexcept {
+    return {row(y), width()};
+  }
+
+  /// The whole row, including padding. The last row has no padding.
+  [[nodiscard]] GstRowSpan<Pixel> paddedRowSpan(guint y) const noexcept {
+    return {row(y), y < paddedRows() ? paddedWidth() : width()};
+  }
+
+private:
+  std::uint8_t *m_data;
+  guint m_rowBytes;
+  guint m_height;
+  gint m_stride;
+};
+
+/// Scoped gst_video_frame_map()/gst_video_frame_unmap()
+class GstMappedVideoFrame {
+public:
+  /// Maps \p buffer, described by \p info.
+  /// @throws std::runtime_error if the buffer can't be mapped
+  GstMappedVideoFrame(const GstPtr<GstBuffer> &buffer, const GstVideoInfo &info,
+                      GstMapFlags flags) {
+    if (!buffer ||
+        gst_video_frame_map(&m_frame, &info, buffer.self(), flags) == FALSE) {
+      throw std::runtime_error("GstMappedVideoFrame: cannot map buffer");
+    }
+    m_mapped = true;
+  }
+
+  GstMappedVideoFrame(GstMappedVideoFrame &&other) noexcept
+      : m_frame(other.m_frame), m_mapped(other.m_mapped) {
+    other.m_mapped = false;
+  }
+  GstMappedVideoFrame &operator=(GstMappedVideoFrame &&) = delete;
+  GstMappedVideoFrame(const GstMappedVideoFrame &) = delete;
+  GstMappedVideoFrame &operator=(const GstMappedVideoFrame &) = delete;
+
+  ~GstMappedVideoFrame() {
+    if (m_mapped) {
+      gst_video_frame_unmap(&m_frame);
+    }
+  }
+
+  [[nodiscard]] guint planes() const noexcept {
+    return GST_VIDEO_FRAME_N_PLANES(&m_frame);
+  }
+  [[nodiscard]] guint width() const noexcept {
+    return GST_VIDEO_FRAME_WIDTH(&m_frame);
+  }
+  [[nodiscard]] guint height() const noexcept {
+    return GST_VIDEO_FRAME_HEIGHT(&m_frame);
+  }
+  [[nodiscard]] GstVideoFormat format() const noexcept {
+    return GST_VIDEO_FRAME_FORMAT(&m_frame);
+  }
+
+  /// View of plane \p index. Rows are read as \p Pixel units.
+  template <typename Pixel = guint8>
+  [[nodiscard]] GstPlaneView<Pixel> plane(guint index) const noexcept {
+    // Planes may hold several components (i.e. NV12 UV); their size is the
+    // one of the first component, times its pixel stride.
+    gint components[GST_VIDEO_MAX_COMPONENTS];
+    gst_video_format_info_component(m_frame.info.finfo, index, components);
+    const gint stride = GST_VIDEO_FRAME_PLANE_STRIDE(&m_frame, index);
+    guint rowBytes = static_cast<guint>(stride);
+    guint height = GST_VIDEO_FRAME_HEIGHT(&m_frame);
+    if (components[0] >= 0) {
+      const gint pixelStride =
+          GST_VIDEO_FRAME_COMP_PSTRIDE(&m_frame, components[0]);
+      height = GST_VIDEO_FRAME_COMP_HEIGHT(&m_frame, components[0]);
+      if (pixelStride > 0) {
+        rowBytes = GST_VIDEO_FRAME_COMP_WIDTH(&m_frame, components[0]) *
+                   static_cast<guint>(pixelStride);
+      }
+    }
+    return {GST_VIDEO_FRAME_PLANE_DATA(&m_frame, index), rowBytes, height,
+            stride};
+  }
+
+  /// The mapped GstVideoFrame, for the gst_video_* API
+  [[nodiscard]] GstVideoFrame *self() noexcept { return &m_frame; }
+
+private:
+  GstVideoFrame m_frame{};
+  bool m_mapped = false;
+};
+
+/// Input and output frames of a transform, mapped together.
+/// When both buffers are the same (in-place), a single read-write mapping is
+/// shared, so input() and output() return the same frame.
+class GstMappedVideoTransform {
+public:
+  /// @throws std::invalid_argument if the transform is in-place but the
+  /// infos differ (a single mapping has a single layout)
+  /// @throws std::runtime_error if any buffer can't be mapped
+  GstMappedVideoTransform(const GstPtr<GstBuffer> &input,
+                          const GstVideoInfo &inputInfo,
+                          const GstPtr<GstBuffer> &output,
+                          const GstVideoInfo &outputInfo)
+      : m_input(input, inputInfo,
+                inputFlags(input, inputInfo, output, outputInfo)) {
+    if (input.self() != output.self()) {
+      m_output.emplace(output, outputInfo, GST_MAP_WRITE);
+    }
+  }
+
+  [[nodiscard]] bool isInPlace() const noexcept { return !m_output; }
+  [[nodiscard]] GstMappedVideoFrame &input() noexcept { return m_input; }
+  [[nodiscard]] GstMappedVideoFrame &output() noexcept {
+    return m_output ? *m_output : m_input;
+  }
+
+private:
+  static GstMapFlags inputFlags(const GstPtr<GstBuffer> &input,
+                                const GstVideoInfo &inputInfo,
+                                const GstPtr<GstBuffer> &output,
+                                const GstVideoInfo &outputInfo) {
+    if (input.self() != output.self()) {
+      return GST_MAP_READ;
+    }
+    if (gst_video_info_is_equal(&inputInfo, &outputInfo) == FALSE) {
+      throw std::invalid_argument(
+          "GstMappedVideoTransform: in-place with different video infos");
+    }
+    return GST_MAP_READWRITE;
+  }
+
+  GstMappedVideoFrame m_input;
+  std::optional<GstMappedVideoFrame> m_output;
+};
+
+#endif
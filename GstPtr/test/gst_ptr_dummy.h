@@ -0,0 +1,122 @@
+//
+// Dummy glib/gstreamer, shared by the tests and benchmarks
+// It's not necessary using the real libraries for testing GstPtr<> functionality
+//
+// Include it before any GstPtr header. What only one test needs (GValues,
+// iterators, more types...) is defined by that test, after this include.
+//
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+using GType = long;
+using gboolean = int;
+using gchar = char;
+using gint = int;
+using guint = unsigned int;
+using gpointer = void *;
+constexpr gboolean TRUE = 1;
+constexpr gboolean FALSE = 0;
+
+// The types mapped by gst_ptr.h
+constexpr GType G_TYPE_OBJECT = 0x01;
+constexpr GType GST_TYPE_OBJECT = 0x02;
+constexpr GType GST_TYPE_ELEMENT = 0x03;
+constexpr GType GST_TYPE_BIN = 0x04;
+constexpr GType GST_TYPE_PIPELINE = 0x05;
+constexpr GType GST_TYPE_CAPS = 0x06;
+constexpr GType GST_TYPE_BUS = 0x07;
+constexpr GType G_TYPE_NONE = 0x08;
+constexpr GType G_TYPE_PARAM = 0x09;
+constexpr GType GST_TYPE_PAD = 0x0A;
+constexpr GType GST_TYPE_BUFFER = 0x0B;
+constexpr GType GST_TYPE_EVENT = 0x0C;
+constexpr GType GST_TYPE_CONTEXT = 0x0D;
+
+// A new object has one reference, as in GLib. Refcounts are atomic, so
+// objects can be shared among threads. Tests can override ref/unref to
+// count calls.
+struct GTypeInstance {
+    virtual ~GTypeInstance() = default;
+    virtual void ref() {
+        m_refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    /// Returns the references left
+    virtual long unref() {
+        return m_refCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    }
+    virtual void sink() {
+        if (m_floating) {
+            m_floating = false;
+        } else {
+            ref();
+        }
+    }
+    const int m_dummy = 0x69;
+    std::atomic<long> m_refCount{1};
+    bool m_floating = false;
+};
+struct GObject : public GTypeInstance {};
+struct GstObject : public GObject {};
+struct GstElement : public GstObject {};
+struct GstPad : public GstObject {};
+struct GstBin : public GstElement {};
+struct GstPipeline : public GstBin {};
+struct GstBus : public GstObject {};
+class GstMiniObject : public GTypeInstance {};
+class GstCaps : public GstMiniObject {};
+class GstBuffer : public GstMiniObject {};
+class GstEvent : public GstMiniObject {};
+class GstContext : public GstMiniObject {};
+struct GParamSpec : public GTypeInstance {
+    const gchar *name = nullptr;
+    guint flags = 0;
+    GType value_type = 0;
+    GType owner_type = 0;
+    guint param_id = 0;
+};
+struct GMainLoop : public GTypeInstance {};
+
+// NOLINTNEXTLINE
+inline void g_object_unref(GObject *obj) {
+    const long left = obj->unref();
+    assert(left >= 0);
+    if (left == 0) {
+        delete obj;
+    }
+}
+// NOLINTNEXTLINE
+inline void g_object_ref(GObject *obj) { obj->ref(); }
+// NOLINTNEXTLINE
+inline void g_object_ref_sink(GObject *obj) { obj->sink(); }
+// NOLINTNEXTLINE
+inline void gst_mini_object_unref(GstMiniObject *obj) {
+    const long left = obj->unref();
+    assert(left >= 0);
+    if (left == 0) {
+        delete obj;
+    }
+}
+// NOLINTNEXTLINE
+inline void gst_mini_object_ref(GstMiniObject *obj) { obj->ref(); }
+// NOLINTNEXTLINE
+inline void g_param_spec_unref(GParamSpec *pspec) {
+    const long left = pspec->unref();
+    assert(left >= 0);
+    if (left == 0) {
+        delete pspec;
+    }
+}
+// NOLINTNEXTLINE
+inline GParamSpec *g_param_spec_ref(GParamSpec *pspec) {
+    pspec->ref();
+    return pspec;
+}
+
+constexpr guint G_PARAM_READABLE = 1U << 0U;
+constexpr guint G_PARAM_WRITABLE = 1U << 1U;
+constexpr guint G_PARAM_READWRITE = G_PARAM_READABLE | G_PARAM_WRITABLE;
+constexpr guint G_PARAM_CONSTRUCT_ONLY = 1U << 3U;
+constexpr guint G_PARAM_LAX_VALIDATION = 1U << 4U;
+constexpr guint G_PARAM_EXPLICIT_NOTIFY = 1U << 30U;
@@ -0,0 +1,123 @@
+//
+// Dummy GValue of the fundamental types, shared by the tests that need them
+// Include it after gst_ptr_dummy.h. Derived types (enums, flags) keep their
+// fundamental type in the lowest byte, so G_TYPE_FUNDAMENTAL() is a mask.
+//
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+
+using gint64 = long long;
+using guint64 = unsigned long long;
+using gfloat = float;
+using gdouble = double;
+
+constexpr GType G_TYPE_INVALID = 0x00;
+constexpr GType G_TYPE_BOOLEAN = 0x20;
+constexpr GType G_TYPE_INT = 0x21;
+constexpr GType G_TYPE_UINT = 0x22;
+constexpr GType G_TYPE_INT64 = 0x23;
+constexpr GType G_TYPE_UINT64 = 0x24;
+constexpr GType G_TYPE_FLOAT = 0x25;
+constexpr GType G_TYPE_DOUBLE = 0x26;
+constexpr GType G_TYPE_STRING = 0x27;
+constexpr GType G_TYPE_ENUM = 0x28;
+constexpr GType G_TYPE_FLAGS = 0x29;
+#define G_TYPE_FUNDAMENTAL(type) ((type) & 0xFF)
+
+struct GValue {
+    GType g_type;
+    gint64 v_int;
+    guint64 v_uint;
+    gdouble v_double;
+    gchar *v_string;
+};
+#define G_VALUE_INIT {0, 0, 0, 0.0, nullptr}
+#define G_IS_VALUE(value) ((value)->g_type != 0)
+
+// NOLINTNEXTLINE
+inline const gchar *g_type_name(GType type) {
+    switch (G_TYPE_FUNDAMENTAL(type)) {
+    case G_TYPE_BOOLEAN: return "gboolean";
+    case G_TYPE_INT: return "gint";
+    case G_TYPE_UINT: return "guint";
+    case G_TYPE_INT64: return "gint64";
+    case G_TYPE_UINT64: return "guint64";
+    case G_TYPE_FLOAT: return "gfloat";
+    case G_TYPE_DOUBLE: return "gdouble";
+    case G_TYPE_STRING: return "gchararray";
+    case G_TYPE_ENUM: return "GEnum";
+    case G_TYPE_FLAGS: return "GFlags";
+    default: return "invalid";
+    }
+}
+
+// NOLINTNEXTLINE
+inline GValue *g_value_init(GValue *value, GType type) {
+    assert(value->g_type == 0 && type != G_TYPE_INVALID);
+    value->g_type = type;
+    return value;
+}
+// NOLINTNEXTLINE
+inline void g_value_reset(GValue *value) {
+    std::free(value->v_string);
+    *value = GValue{value->g_type, 0, 0, 0.0, nullptr};
+}
+// NOLINTNEXTLINE
+inline void g_value_unset(GValue *value) {
+    g_value_reset(value);
+    value->g_type = 0;
+}
+// NOLINTNEXTLINE
+inline void g_value_copy(const GValue *source, GValue *destination) {
+    g_value_reset(destination);
+    *destination = *source;
+    if (source->v_string != nullptr) {
+        destination->v_string = strdup(source->v_string);
+    }
+}
+
+// NOLINTNEXTLINE
+inline void g_value_set_boolean(GValue *value, gboolean content) { value->v_int = content; }
+// NOLINTNEXTLINE
+inline gboolean g_value_get_boolean(const GValue *value) { return static_cast<gboolean>(value->v_int); }
+// NOLINTNEXTLINE
+inline void g_value_set_int(GValue *value, gint content) { value->v_int = content; }
+// NOLINTNEXTLINE
+inline gint g_value_get_int(const GValue *value) { return static_cast<gint>(value->v_int); }
+// NOLINTNEXTLINE
+inline void g_value_set_enum(GValue *value, gint content) { value->v_int = content; }
+// NOLINTNEXTLINE
+inline gint g_value_get_enum(const GValue *value) { return static_cast<gint>(value->v_int); }
+// NOLINTNEXTLINE
+inline void g_value_set_int64(GValue *value, gint64 content) { value->v_int = content; }
+// NOLINTNEXTLINE
+inline gint64 g_value_get_int64(const GValue *value) { return value->v_int; }
+// NOLINTNEXTLINE
+inline void g_value_set_uint(GValue *value, guint content) { value->v_uint = content; }
+// NOLINTNEXTLINE
+inline guint g_value_get_uint(const GValue *value) { return static_cast<guint>(value->v_uint); }
+// NOLINTNEXTLINE
+inline void g_value_set_flags(GValue *value, guint content) { value->v_uint = content; }
+// NOLINTNEXTLINE
+inline guint g_value_get_flags(const GValue *value) { return static_cast<guint>(value->v_uint); }
+// NOLINTNEXTLINE
+inline void g_value_set_uint64(GValue *value, guint64 content) { value->v_uint = content; }
+// NOLINTNEXTLINE
+inline guint64 g_value_get_uint64(const GValue *value) { return value->v_uint; }
+// NOLINTNEXTLINE
+inline void g_value_set_float(GValue *value, gfloat content) { value->v_double = content; }
+// NOLINTNEXTLINE
+inline gfloat g_value_get_float(const GValue *value) { return static_cast<gfloat>(value->v_double); }
+// NOLINTNEXTLINE
+inline void g_value_set_double(GValue *value, gdouble content) { value->v_double = content; }
+// NOLINTNEXTLINE
+inline gdouble g_value_get_double(const GValue *value) { return value->v_double; }
+// NOLINTNEXTLINE
+inline void g_value_set_string(GValue *value, const gchar *content) {
+    std::free(value->v_string);
+    value->v_string = content != nullptr ? strdup(content) : nullptr;
+}
+// NOLINTNEXTLINE
+inline const gchar *g_value_get_string(const GValue *value) { return value->v_string; }
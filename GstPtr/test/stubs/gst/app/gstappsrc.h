@@ -0,0 +1,3 @@
+// Empty on purpose: it only makes __has_include(<gst/app/gstappsrc.h>) true.
+// The test defines the dummy gst-app API before including gst_ptr_appsrc.h.
+#pragma once
@@ -0,0 +1,3 @@
+// Empty on purpose: it only makes __has_include(<gst/base/gstadapter.h>) true.
+// The test defines the dummy gst-base API before including gst_ptr_adapter.h.
+#pragma once
@@ -0,0 +1,4 @@
+// Empty on purpose: it only makes __has_include(<gst/video/video.h>) true.
+// The test defines the dummy gst-video API before including
+// gst_ptr_video_frame.h.
+#pragma once
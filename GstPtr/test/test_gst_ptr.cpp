@@ -2,96 +2,11 @@
 
 // Note: tests have to be run with valgrind, in order to catch leaks.
 
-//
-// Dummy glib/gstreamer
-// It's not necessary using the real libraries for testing GstPtr<> functionality
-//
-using GType = long;
-constexpr GType G_TYPE_OBJECT = 0x01;
-constexpr GType GST_TYPE_OBJECT = 0x02;
-constexpr GType GST_TYPE_ELEMENT = 0x03;
-constexpr GType GST_TYPE_BIN = 0x04;
-constexpr GType GST_TYPE_PIPELINE = 0x05;
-constexpr GType GST_TYPE_CAPS = 0x06;
-constexpr GType GST_TYPE_BUS = 0x07;
-constexpr GType G_TYPE_NONE = 0x08;
-constexpr GType G_TYPE_PARAM = 0x09;
-constexpr GType GST_TYPE_PAD = 0x0A;
-constexpr GType GST_TYPE_BUFFER = 0x0B;
-constexpr GType GST_TYPE_EVENT = 0x0C;
-constexpr GType GST_TYPE_CONTEXT = 0x0D;
-constexpr bool TRUE = true;
-
-struct GTypeInstance {
-    virtual ~GTypeInstance() = default;
-    virtual void ref() {
-        m_refCount++;
-    }
-    virtual void unref() {
-        m_refCount--;
-    }
-    virtual void sink() {
-        if (m_floating) {
-            m_refCount++;
-        }
-    }
-    const int m_dummy=0x69;
-    long m_refCount = 0;
-    bool m_floating=false;
-};
-struct GObject : public GTypeInstance {};
-struct GstObject : public GObject {};
-struct GstElement : public GObject {};
-struct GstPad : public GstObject {};
-struct GstBin : public GstElement {};
-struct GstPipeline : public GstBin {};
-struct GstBus : public GstObject {};
-class GstMiniObject : public GTypeInstance {};
-class GstCaps : public GstMiniObject {};
-class GstBuffer : public GstMiniObject {};
-class GstEvent : public GstMiniObject {};
-class GstContext : public GstMiniObject {};
-struct GParamSpec : public GTypeInstance {};
-struct GMainLoop : public GTypeInstance {};
-
-// NOLINTNEXTLINE
-void g_object_unref(GObject *obj) {
-    obj->unref();
-    assert (obj->m_refCount >= 0);
-    if (obj->m_refCount == 0) {
-        delete obj;
-    }
-}
-
-// NOLINTNEXTLINE
-void g_object_ref(GObject *obj) {
-    obj->ref();
-}
-
-// NOLINTNEXTLINE
-void g_object_ref_sink(GObject *obj) {
-    obj->sink();
-}
-
-
-// NOLINTNEXTLINE
-void gst_mini_object_unref(GstMiniObject *obj) {
-    obj->unref();
-    assert (obj->m_refCount >= 0);
-    if (obj->m_refCount == 0) {
-        delete obj;
-    }
-}
-// NOLINTNEXTLINE
-void gst_mini_object_ref(GstMiniObject *obj) {
-    obj->ref();
-}
+#include "gst_ptr_dummy.h"
 
 // NOLINTNEXTLINE
 GObject *g_function_full_transfer() {
-    auto *newObject = new GObject();
-    g_object_ref(newObject);
-    return newObject;
+    return new GObject();
 }
 // NOLINTNEXTLINE
 GObject *g_function_float_transfer_floating() {
@@ -103,15 +18,11 @@ GObject *g_function_float_transfer_floating() {
 
 // NOLINTNEXTLINE
 GstPipeline *g_function_full_transfer_pipeline() {
-    auto *newObject = new GstPipeline();
-    g_object_ref(newObject);
-    return newObject;
+    return new GstPipeline();
 }
 // NOLINTNEXTLINE
 GstCaps *g_function_full_transfer_caps() {
-    auto *newObject = new GstCaps();
-    gst_mini_object_ref(newObject);
-    return newObject;
+    return new GstCaps();
 }
 
 // NOLINTNEXTLINE
@@ -121,9 +32,7 @@ void g_function_get_full_transfer(GObject *object) {
 
 // NOLINTNEXTLINE
 GObject *g_function_transfer_none() {
-    auto *newObject = new GObject();
-    g_object_ref(newObject);
-    return newObject;
+    return new GObject();
 }
 // NOLINTNEXTLINE
 void g_function_transfer_none_release(GObject *object) {
@@ -247,6 +156,16 @@ TEST(GstPtr, move_assignment) {
     ASSERT_EQ(obj.self(), nullptr);
 }
 
+TEST(GstPtr, move_re_assignment) {
+    GstPtr<GObject> objA = g_function_full_transfer();
+    GstPtr<GObject> objB = g_function_full_transfer();
+    GstPtr<GObject> objC{objB};
+    objB = std::move(objA);
+    ASSERT_EQ(objB.self()->m_refCount, 1);
+    ASSERT_EQ(objC.self()->m_refCount, 1);
+    ASSERT_EQ(objA.self(), nullptr);
+}
+
 TEST(GstPtr, pass_transfer_full) {
     GstPtr<GObject> obj = g_function_full_transfer();
     g_function_get_full_transfer(obj.transferFull());
@@ -302,3 +221,36 @@ TEST(GstPtr, dereference_operator) {
     GstPtr<GstCaps> obj= g_function_full_transfer_caps();
     ASSERT_EQ(obj->m_dummy,0x69);
 }
+
+TEST(GstPtrView, does_not_ref) {
+    GstPtr<GstPipeline> pipe = g_function_full_transfer_pipeline();
+    GstPtrView<GstPipeline> view{pipe};
+    GstPtrView<GstPipeline> other = pipe.self();
+    ASSERT_EQ(view.self(), pipe.self());
+    ASSERT_TRUE(view == other);
+    g_function_get_self_gst_object(view.self<GstObject>());
+    ASSERT_EQ(pipe.self()->m_refCount, 1);
+}
+
+TEST(GstPtrView, owned) {
+    GstPtr<GstCaps> caps = g_function_full_transfer_caps();
+    GstPtrView<GstCaps> view{caps};
+    {
+        GstPtr<GstCaps> owner = view.owned();
+        ASSERT_EQ(caps.self()->m_refCount, 2);
+    }
+    ASSERT_EQ(caps.self()->m_refCount, 1);
+    ASSERT_FALSE((bool)GstPtrView<GstCaps>{});
+}
+
+//Static test. Pass if it compiles.
+TEST(GstPtrView, from_derived) {
+    GstPtr<GstPipeline> pipe = g_function_full_transfer_pipeline();
+    GstPtrView<GstBin> bin{pipe};
+    GstPtrView<GstObject> object{bin};
+    ASSERT_EQ((GstPipeline *)object.self(), pipe.self());
+    static_assert(!std::is_constructible_v<GstPtrView<GstPipeline>,
+                                           const GstPtr<GstBin> &>);
+    static_assert(!std::is_constructible_v<GstPtrView<GstCaps>,
+                                           const GstPtr<GstBuffer> &>);
+}
@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+
+//
+// Dummy gst-base
+// A GstAdapter over a queue of byte buffers. As the real one, it has a single
+// mapping: mapping again, or unmapping, frees the bytes it assembled.
+//
+using gsize = std::size_t;
+using gssize = std::ptrdiff_t;
+using guint32 = std::uint32_t;
+using guint64 = std::uint64_t;
+using gconstpointer = const void *;
+using GstClockTime = guint64;
+constexpr GstClockTime GST_CLOCK_TIME_NONE = std::numeric_limits<guint64>::max();
+constexpr guint64 GST_BUFFER_OFFSET_NONE = std::numeric_limits<guint64>::max();
+constexpr GType GST_TYPE_ADAPTER = 0x0E;
+
+class ByteBuffer : public GstBuffer {
+public:
+    ByteBuffer(std::vector<std::uint8_t> bytes, GstClockTime pts)
+        : m_bytes(std::move(bytes)), m_pts(pts) {}
+    const std::vector<std::uint8_t> m_bytes;
+    const GstClockTime m_pts;
+};
+
+struct GstAdapter : public GObject {
+    ~GstAdapter() override {
+        for (auto *chunk : m_chunks) {
+            gst_mini_object_unref(chunk);
+        }
+    }
+    const ByteBuffer &chunk(std::size_t index) const {
+        return *static_cast<const ByteBuffer *>(m_chunks[index]);
+    }
+    std::deque<GstBuffer *> m_chunks;
+    /// Bytes already flushed from the first chunk
+    std::size_t m_skip = 0;
+    std::vector<std::uint8_t> m_assembled;
+    bool m_mapped = false;
+    int m_maps = 0;
+    int m_unmaps = 0;
+};
+
+// NOLINTNEXTLINE
+gsize gst_buffer_get_size(GstBuffer *buffer) {
+    return static_cast<ByteBuffer *>(buffer)->m_bytes.size();
+}
+// NOLINTNEXTLINE
+GstAdapter *gst_adapter_new() { return new GstAdapter(); }
+// NOLINTNEXTLINE
+void gst_adapter_push(GstAdapter *adapter, GstBuffer *buffer) {
+    adapter->m_chunks.push_back(buffer);
+}
+// NOLINTNEXTLINE
+gsize gst_adapter_available(GstAdapter *adapter) {
+    gsize size = 0;
+    for (std::size_t index = 0; index < adapter->m_chunks.size(); ++index) {
+        size += adapter->chunk(index).m_bytes.size();
+    }
+    return size - adapter->m_skip;
+}
+// NOLINTNEXTLINE
+gsize gst_adapter_available_fast(GstAdapter *adapter) {
+    return adapter->m_chunks.empty()
+               ? 0
+               : adapter->chunk(0).m_bytes.size() - adapter->m_skip;
+}
+std::uint8_t byteAt(GstAdapter *adapter, std::size_t offset) {
+    offset += adapter->m_skip;
+    std::size_t index = 0;
+    while (offset >= adapter->chunk(index).m_bytes.size()) {
+        offset -= adapter->chunk(index++).m_bytes.size();
+    }
+    return adapter->chunk(index).m_bytes[offset];
+}
+// NOLINTNEXTLINE
+void gst_adapter_unmap(GstAdapter *adapter) {
+    if (adapter->m_mapped) {
+        adapter->m_mapped = false;
+        ++adapter->m_unmaps;
+        adapter->m_assembled = {};
+    }
+}
+// NOLINTNEXTLINE
+gconstpointer gst_adapter_map(GstAdapter *adapter, gsize size) {
+    if (size > gst_adapter_available(adapter)) {
+        return nullptr;
+    }
+    gst_adapter_unmap(adapter);
+    adapter->m_mapped = true;
+    ++adapter->m_maps;
+    if (size <= gst_adapter_available_fast(adapter)) {
+        return adapter->chunk(0).m_bytes.data() + adapter->m_skip;
+    }
+    for (std::size_t offset = 0; offset < size; ++offset) {
+        adapter->m_assembled.push_back(byteAt(adapter, offset));
+    }
+    return adapter->m_assembled.data();
+}
+// NOLINTNEXTLINE
+void gst_adapter_flush(GstAdapter *adapter, gsize size) {
+    gst_adapter_unmap(adapter);
+    size += adapter->m_skip;
+    while (!adapter->m_chunks.empty() &&
+           size >= adapter->chunk(0).m_bytes.size()) {
+        size -= adapter->chunk(0).m_bytes.size();
+        gst_mini_object_unref(adapter->m_chunks.front());
+        adapter->m_chunks.pop_front();
+    }
+    adapter->m_skip = size;
+}
+// NOLINTNEXTLINE
+void gst_adapter_clear(GstAdapter *adapter) {
+    gst_adapter_flush(adapter, gst_adapter_available(adapter));
+}
+// NOLINTNEXTLINE
+GstBuffer *gst_adapter_take_buffer_fast(GstAdapter *adapter, gsize size) {
+    std::vector<std::uint8_t> bytes;
+    for (std::size_t offset = 0; offset < size; ++offset) {
+        bytes.push_back(byteAt(adapter, offset));
+    }
+    gst_adapter_flush(adapter, size);
+    return new ByteBuffer(std::move(bytes), GST_CLOCK_TIME_NONE);
+}
+// NOLINTNEXTLINE
+gssize gst_adapter_masked_scan_uint32_peek(GstAdapter *adapter, guint32 mask,
+                                           guint32 pattern, gsize offset,
+                                           gsize size, guint32 *) {
+    for (gsize start = offset; start + 4 <= offset + size; ++start) {
+        guint32 value = 0;
+        for (gsize index = 0; index < 4; ++index) {
+            value = (value << 8U) | byteAt(adapter, start + index);
+        }
+        if ((value & mask) == pattern) {
+            return static_cast<gssize>(start);
+        }
+    }
+    return -1;
+}
+// The chunk holding the byte gives its pts
+// NOLINTNEXTLINE
+GstClockTime gst_adapter_prev_pts_at_offset(GstAdapter *adapter, gsize offset,
+                                            guint64 *distance) {
+    offset += adapter->m_skip;
+    std::size_t index = 0;
+    while (offset >= adapter->chunk(index).m_bytes.size()) {
+        offset -= adapter->chunk(index++).m_bytes.size();
+    }
+    *distance = offset;
+    return adapter->chunk(index).m_pts;
+}
+// NOLINTNEXTLINE
+GstClockTime gst_adapter_prev_dts_at_offset(GstAdapter *, gsize,
+                                            guint64 *distance) {
+    *distance = 0;
+    return GST_CLOCK_TIME_NONE;
+}
+// NOLINTNEXTLINE
+guint64 gst_adapter_prev_offset(GstAdapter *, guint64 *distance) {
+    *distance = 0;
+    return GST_BUFFER_OFFSET_NONE;
+}
+
+//
+// The tests
+//
+
+#include "../gst_ptr_adapter.h"
+
+GstPtr<GstBuffer> chunk(std::vector<std::uint8_t> bytes,
+                        GstClockTime pts = GST_CLOCK_TIME_NONE) {
+    return new ByteBuffer(std::move(bytes), pts);
+}
+
+TEST(GstByteAdapter, peek_contiguous_only_in_first_chunk) {
+    GstByteAdapter adapter;
+    adapter.push(chunk({1, 2, 3}));
+    adapter.push(chunk({4, 5}));
+    ASSERT_EQ(adapter.available(), 5U);
+    ASSERT_EQ(adapter.availableContiguous(), 3U);
+    {
+        auto span = adapter.peekContiguous(3);
+        ASSERT_TRUE(span);
+        ASSERT_EQ((std::vector<std::uint8_t>{span->begin(), span->end()}),
+                  (std::vector<std::uint8_t>{1, 2, 3}));
+    }
+    ASSERT_FALSE(adapter.peekContiguous(4));
+    ASSERT_FALSE(adapter.peekContiguous(0));
+    ASSERT_EQ(adapter.stats().bytesCopied, 0U);
+}
+
+TEST(GstByteAdapter, peek_copies_across_chunks) {
+    GstByteAdapter adapter;
+    adapter.push(chunk({1, 2, 3}));
+    adapter.push(chunk({4, 5}));
+    {
+        auto span = adapter.peek(4);
+        ASSERT_TRUE(span);
+        ASSERT_EQ((*span)[3], 4);
+    }
+    ASSERT_EQ(adapter.stats().bytesCopied, 4U);
+    ASSERT_FALSE(adapter.peek(6));
+    ASSERT_EQ(adapter.self()->m_maps, adapter.self()->m_unmaps);
+}
+
+TEST(GstByteAdapter, take_and_flush) {
+    GstByteAdapter adapter;
+    adapter.push(chunk({1, 2, 3}));
+    adapter.push(chunk({4, 5}));
+    GstPtr<GstBuffer> taken = adapter.takeBuffer(4);
+    ASSERT_EQ(static_cast<ByteBuffer *>(taken.self())->m_bytes,
+              (std::vector<std::uint8_t>{1, 2, 3, 4}));
+    ASSERT_FALSE(adapter.takeBuffer(2));
+    adapter.flush(10);
+    ASSERT_EQ(adapter.available(), 0U);
+    ASSERT_EQ(adapter.stats().bytesPushed, 5U);
+    ASSERT_EQ(adapter.stats().bytesTaken, 4U);
+}
+
+TEST(GstByteAdapter, masked_scan) {
+    GstByteAdapter adapter;
+    adapter.push(chunk({0x12, 0x00, 0x00, 0x01, 0x65, 0x00}));
+    adapter.push(chunk({0x00, 0x01, 0x41}));
+    ASSERT_EQ(adapter.maskedScan(START_CODE_MASK, START_CODE_PATTERN), 1);
+    // The second start code begins in the first chunk and ends in the next
+    ASSERT_EQ(adapter.maskedScan(START_CODE_MASK, START_CODE_PATTERN, 2), 5);
+    ASSERT_EQ(adapter.maskedScan(START_CODE_MASK, START_CODE_PATTERN, 6), -1);
+    ASSERT_EQ(adapter.self()->m_maps, adapter.self()->m_unmaps);
+}
+
+TEST(GstByteAdapter, timestamp_at) {
+    GstByteAdapter adapter;
+    adapter.push(chunk({1, 2, 3}, 1000));
+    adapter.push(chunk({4, 5}, 2000));
+    const GstAdapterTimestamp timestamp = adapter.timestampAt(4);
+    ASSERT_EQ(timestamp.pts, 2000U);
+    ASSERT_EQ(timestamp.distance, 1U);
+    ASSERT_EQ(timestamp.dts, GST_CLOCK_TIME_NONE);
+    ASSERT_EQ(timestamp.offset, GST_BUFFER_OFFSET_NONE);
+}
+
+TEST(GstByteAdapter, one_span_at_a_time) {
+    GstByteAdapter adapter;
+    adapter.push(chunk({1, 2, 3}));
+    adapter.push(chunk({4, 5}));
+    {
+        auto span = adapter.peek(4);
+        ASSERT_TRUE(span);
+        // Each of these would drop the mapping the span points to
+        ASSERT_THROW((void)adapter.peek(1), std::logic_error);
+        ASSERT_THROW((void)adapter.peekContiguous(1), std::logic_error);
+        ASSERT_THROW(
+            (void)adapter.maskedScan(START_CODE_MASK, START_CODE_PATTERN),
+            std::logic_error);
+        ASSERT_THROW((void)adapter.takeBuffer(1), std::logic_error);
+        ASSERT_THROW(adapter.flush(1), std::logic_error);
+        ASSERT_THROW(adapter.clear(), std::logic_error);
+        // Appending doesn't touch the mapped bytes
+        adapter.push(chunk({6}));
+        ASSERT_EQ((std::vector<std::uint8_t>{span->begin(), span->end()}),
+                  (std::vector<std::uint8_t>{1, 2, 3, 4}));
+        ASSERT_EQ(adapter.self()->m_maps, 1);
+    }
+    ASSERT_FALSE(adapter.self()->m_mapped);
+    ASSERT_TRUE(adapter.peek(6));
+    adapter.flush(1);
+    ASSERT_EQ(adapter.available(), 5U);
+}
+
+TEST(GstByteAdapter, moved_span_unmaps_once) {
+    GstByteAdapter adapter;
+    adapter.push(chunk({1, 2, 3}));
+    {
+        std::optional<GstAdapterSpan> moved;
+        {
+            auto span = adapter.peekContiguous(2);
+            moved.emplace(std::move(*span));
+        }
+        ASSERT_TRUE(adapter.self()->m_mapped);
+        ASSERT_EQ((*moved)[1], 2);
+        ASSERT_THROW((void)adapter.peek(1), std::logic_error);
+    }
+    ASSERT_EQ(adapter.self()->m_unmaps, 1);
+    ASSERT_TRUE(adapter.peek(1));
+}
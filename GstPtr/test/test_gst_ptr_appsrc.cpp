@@ -0,0 +1,395 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+
+//
+// Dummy gst-app
+// An appsrc that records what it's pushed and emits enough-data once
+// max-buffers are queued, as appsrc does. The tests emit need-data and
+// seek-data, as the streaming thread would.
+//
+using guint64 = unsigned long long;
+using GstClockTime = guint64;
+using GDestroyNotify = void (*)(gpointer);
+#define GST_CHECK_VERSION(major, minor, micro) 1
+constexpr GType GST_TYPE_BUFFER_LIST = 0x0E;
+constexpr GType GST_TYPE_APP_SRC = 0x10;
+
+enum GstFlowReturn { GST_FLOW_OK = 0, GST_FLOW_FLUSHING = -2 };
+
+std::atomic<int> g_buffersFreed{0};
+
+class NumberedBuffer : public GstBuffer {
+public:
+    explicit NumberedBuffer(int number) : m_number(number) {}
+    ~NumberedBuffer() override { ++g_buffersFreed; }
+    const int m_number;
+};
+
+class GstBufferList : public GstMiniObject {
+public:
+    ~GstBufferList() override {
+        for (auto *buffer : m_buffers) {
+            gst_mini_object_unref(buffer);
+        }
+    }
+    std::vector<GstBuffer *> m_buffers;
+};
+
+// NOLINTNEXTLINE
+GstBufferList *gst_buffer_list_new_sized(guint size) {
+    auto *list = new GstBufferList();
+    list->m_buffers.reserve(size);
+    return list;
+}
+// NOLINTNEXTLINE
+guint gst_buffer_list_length(GstBufferList *list) {
+    return static_cast<guint>(list->m_buffers.size());
+}
+// NOLINTNEXTLINE
+void gst_buffer_list_add(GstBufferList *list, GstBuffer *buffer) {
+    list->m_buffers.push_back(buffer);
+}
+
+struct GstAppSrc;
+struct GstAppSrcCallbacks {
+    void (*need_data)(GstAppSrc *, guint, gpointer);
+    void (*enough_data)(GstAppSrc *, gpointer);
+    gboolean (*seek_data)(GstAppSrc *, guint64, gpointer);
+};
+
+struct GstAppSrc : public GstElement {
+    GstFlowReturn push(std::vector<GstBuffer *> buffers) {
+        bool full = false;
+        GstFlowReturn result;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            result = m_flow;
+            if (result == GST_FLOW_OK) {
+                for (auto *buffer : buffers) {
+                    m_pushed.push_back(static_cast<NumberedBuffer *>(buffer)->m_number);
+                }
+                m_calls.push_back(buffers.size());
+                m_queued += buffers.size();
+                full = m_maxBuffers != 0 && m_queued >= m_maxBuffers;
+            }
+        }
+        for (auto *buffer : buffers) {
+            gst_mini_object_unref(buffer);
+        }
+        if (full) {
+            m_callbacks.enough_data(this, m_userData);
+        }
+        return result;
+    }
+    std::vector<int> pushed() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pushed;
+    }
+    std::vector<std::size_t> calls() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_calls;
+    }
+
+    std::mutex m_mutex;
+    GstAppSrcCallbacks m_callbacks{};
+    gpointer m_userData = nullptr;
+    guint64 m_maxBytes = 0;
+    guint64 m_maxBuffers = 0;
+    GstClockTime m_maxTime = 0;
+    guint64 m_queued = 0;
+    bool m_eos = false;
+    GstFlowReturn m_flow = GST_FLOW_OK;
+    /// Numbers of the pushed buffers, in order
+    std::vector<int> m_pushed;
+    /// Buffers of each push call (more than one for a list)
+    std::vector<std::size_t> m_calls;
+};
+
+// NOLINTNEXTLINE
+gboolean g_type_check_instance_is_a(GTypeInstance *instance, GType type) {
+    return type == GST_TYPE_APP_SRC && dynamic_cast<GstAppSrc *>(instance) != nullptr;
+}
+// NOLINTNEXTLINE
+GTypeInstance *g_type_check_instance_cast(GTypeInstance *instance, GType) { return instance; }
+
+// NOLINTNEXTLINE
+void gst_app_src_set_max_bytes(GstAppSrc *appsrc, guint64 max) { appsrc->m_maxBytes = max; }
+// NOLINTNEXTLINE
+void gst_app_src_set_max_buffers(GstAppSrc *appsrc, guint64 max) { appsrc->m_maxBuffers = max; }
+// NOLINTNEXTLINE
+void gst_app_src_set_max_time(GstAppSrc *appsrc, GstClockTime max) { appsrc->m_maxTime = max; }
+// NOLINTNEXTLINE
+void gst_app_src_set_callbacks(GstAppSrc *appsrc, GstAppSrcCallbacks *callbacks,
+                               gpointer userData, GDestroyNotify) {
+    std::lock_guard<std::mutex> lock(appsrc->m_mutex);
+    appsrc->m_callbacks = *callbacks;
+    appsrc->m_userData = userData;
+}
+// NOLINTNEXTLINE
+GstFlowReturn gst_app_src_push_buffer(GstAppSrc *appsrc, GstBuffer *buffer) {
+    return appsrc->push({buffer});
+}
+// NOLINTNEXTLINE
+GstFlowReturn gst_app_src_push_buffer_list(GstAppSrc *appsrc, GstBufferList *list) {
+    std::vector<GstBuffer *> buffers;
+    std::swap(buffers, list->m_buffers);
+    gst_mini_object_unref(list);
+    return appsrc->push(std::move(buffers));
+}
+// NOLINTNEXTLINE
+GstFlowReturn gst_app_src_end_of_stream(GstAppSrc *appsrc) {
+    std::lock_guard<std::mutex> lock(appsrc->m_mutex);
+    appsrc->m_eos = true;
+    return GST_FLOW_OK;
+}
+// NOLINTNEXTLINE
+guint64 gst_app_src_get_current_level_bytes(GstAppSrc *) { return 0; }
+// NOLINTNEXTLINE
+guint64 gst_app_src_get_current_level_buffers(GstAppSrc *appsrc) {
+    std::lock_guard<std::mutex> lock(appsrc->m_mutex);
+    return appsrc->m_queued;
+}
+// NOLINTNEXTLINE
+GstClockTime gst_app_src_get_current_level_time(GstAppSrc *) { return 0; }
+
+//
+// The tests
+//
+
+#include "../gst_ptr_appsrc.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+GstPtr<GstBuffer> numbered(int number) { return new NumberedBuffer(number); }
+
+// The streaming thread asks for data
+void needData(GstAppSrc *appsrc) {
+    appsrc->m_callbacks.need_data(appsrc, 0, appsrc->m_userData);
+}
+void enoughData(GstAppSrc *appsrc) {
+    appsrc->m_callbacks.enough_data(appsrc, appsrc->m_userData);
+}
+// The streaming thread empties the queue, and asks for more
+void consume(GstAppSrc *appsrc) {
+    {
+        std::lock_guard<std::mutex> lock(appsrc->m_mutex);
+        appsrc->m_queued = 0;
+    }
+    needData(appsrc);
+}
+
+// Waits until \p producer has blocked in the feeder, or returned
+template <typename Result>
+bool isBlocked(std::future<Result> &producer) {
+    return producer.wait_for(50ms) == std::future_status::timeout;
+}
+
+class GstAppSrcFeederTest : public ::testing::Test {
+protected:
+    GstPtr<GstElement> m_element{new GstAppSrc()};
+    GstAppSrc *m_appsrc = static_cast<GstAppSrc *>(m_element.self());
+};
+
+} // namespace
+
+TEST_F(GstAppSrcFeederTest, sets_watermarks) {
+    GstAppSrcFeeder feeder{m_element, {1024, 8, 1000}};
+    ASSERT_EQ(m_appsrc->m_maxBytes, 1024);
+    ASSERT_EQ(m_appsrc->m_maxBuffers, 8);
+    ASSERT_EQ(m_appsrc->m_maxTime, 1000);
+    ASSERT_EQ(feeder.self(), m_appsrc);
+}
+
+TEST_F(GstAppSrcFeederTest, not_an_appsrc) {
+    GstPtr<GstElement> element{new GstElement()};
+    ASSERT_THROW((GstAppSrcFeeder{element, {}}), std::bad_cast);
+}
+
+TEST_F(GstAppSrcFeederTest, pushes_while_accepting) {
+    GstAppSrcFeeder feeder{m_element, {}};
+    for (int number = 0; number < 3; ++number) {
+        ASSERT_EQ(feeder.push(numbered(number)), GstFeedResult::accepted);
+    }
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{0, 1, 2}));
+    ASSERT_EQ(m_appsrc->calls(), (std::vector<std::size_t>{1, 1, 1}));
+    ASSERT_EQ(feeder.stats().buffersPushed, 3);
+    ASSERT_EQ(feeder.stats().listsPushed, 0);
+}
+
+TEST_F(GstAppSrcFeederTest, batches_up_to_batch_size) {
+    // enough-data is emitted by the second push
+    GstAppSrcFeeder feeder{m_element, {0, 2}, 4};
+    for (int number = 0; number < 6; ++number) {
+        ASSERT_EQ(feeder.tryPush(numbered(number)), GstFeedResult::accepted);
+    }
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{0, 1}));
+    auto stats = feeder.stats();
+    ASSERT_EQ(stats.enoughData, 1);
+    ASSERT_EQ(stats.pendingBuffers, 4);
+    ASSERT_EQ(stats.queuedBuffers, 2);
+
+    // The batch is full
+    GstPtr<GstBuffer> buffer = numbered(6);
+    ASSERT_EQ(feeder.tryPush(std::move(buffer)), GstFeedResult::timedOut);
+    ASSERT_TRUE(buffer);
+    ASSERT_EQ(feeder.stats().stalls, 0);
+
+    // The whole batch is pushed at once, on need-data
+    consume(m_appsrc);
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{0, 1, 2, 3, 4, 5}));
+    ASSERT_EQ(m_appsrc->calls(), (std::vector<std::size_t>{1, 1, 4}));
+    stats = feeder.stats();
+    ASSERT_EQ(stats.needData, 1);
+    ASSERT_EQ(stats.pendingBuffers, 0);
+    ASSERT_EQ(stats.listsPushed, 1);
+    ASSERT_EQ(stats.buffersPushed, 6);
+}
+
+TEST_F(GstAppSrcFeederTest, order_across_flush) {
+    GstAppSrcFeeder feeder{m_element, {}, 4};
+    ASSERT_EQ(feeder.push(numbered(0)), GstFeedResult::accepted);
+    enoughData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(1)), GstFeedResult::accepted);
+    ASSERT_EQ(feeder.push(numbered(2)), GstFeedResult::accepted);
+    ASSERT_EQ(feeder.flush(), GstFeedResult::accepted);
+    ASSERT_EQ(feeder.push(numbered(3)), GstFeedResult::accepted);
+    // Accepting again: the pending batch goes before the new buffer
+    needData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(4)), GstFeedResult::accepted);
+    enoughData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(5)), GstFeedResult::accepted);
+    ASSERT_EQ(feeder.endOfStream(), GstFeedResult::accepted);
+
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{0, 1, 2, 3, 4, 5}));
+    ASSERT_TRUE(m_appsrc->m_eos);
+}
+
+TEST_F(GstAppSrcFeederTest, blocks_until_need_data) {
+    GstAppSrcFeeder feeder{m_element, {}, 2};
+    enoughData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(0)), GstFeedResult::accepted);
+    ASSERT_EQ(feeder.push(numbered(1)), GstFeedResult::accepted);
+
+    auto producer = std::async(std::launch::async,
+                               [&feeder] { return feeder.push(numbered(2)); });
+    ASSERT_TRUE(isBlocked(producer));
+    ASSERT_TRUE(m_appsrc->pushed().empty());
+
+    needData(m_appsrc);
+    ASSERT_EQ(producer.get(), GstFeedResult::accepted);
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{0, 1, 2}));
+    auto stats = feeder.stats();
+    ASSERT_EQ(stats.stalls, 1);
+    ASSERT_GT(stats.stallTime.count(), 0);
+}
+
+TEST_F(GstAppSrcFeederTest, timeout_keeps_buffer) {
+    GstAppSrcFeeder feeder{m_element, {}, 1};
+    enoughData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(0)), GstFeedResult::accepted);
+
+    GstPtr<GstBuffer> buffer = numbered(1);
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(feeder.push(std::move(buffer), 20ms), GstFeedResult::timedOut);
+    ASSERT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    ASSERT_TRUE(buffer);
+    ASSERT_EQ(buffer->m_refCount, 1);
+    ASSERT_EQ(feeder.stats().stalls, 1);
+}
+
+TEST_F(GstAppSrcFeederTest, blocked_producer_does_not_block_others) {
+    GstAppSrcFeeder feeder{m_element, {}, 1};
+    enoughData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(0)), GstFeedResult::accepted);
+
+    auto blocked = std::async(std::launch::async,
+                              [&feeder] { return feeder.push(numbered(1)); });
+    ASSERT_TRUE(isBlocked(blocked));
+
+    // Other producers keep their timeouts, and tryPush() doesn't block
+    ASSERT_EQ(feeder.tryPush(numbered(2)), GstFeedResult::timedOut);
+    ASSERT_EQ(feeder.push(numbered(3), 10ms), GstFeedResult::timedOut);
+    ASSERT_EQ(feeder.flush(), GstFeedResult::accepted);
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{0}));
+
+    needData(m_appsrc);
+    ASSERT_EQ(blocked.get(), GstFeedResult::accepted);
+    ASSERT_EQ(feeder.endOfStream(), GstFeedResult::accepted);
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{0, 1}));
+}
+
+TEST_F(GstAppSrcFeederTest, stop_wakes_producers) {
+    GstAppSrcFeeder feeder{m_element, {}, 1};
+    enoughData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(0)), GstFeedResult::accepted);
+
+    GstPtr<GstBuffer> buffer = numbered(1);
+    auto producer = std::async(std::launch::async, [&feeder, &buffer] {
+        return feeder.push(std::move(buffer));
+    });
+    ASSERT_TRUE(isBlocked(producer));
+    feeder.stop();
+    ASSERT_EQ(producer.get(), GstFeedResult::stopped);
+    ASSERT_TRUE(buffer);
+
+    needData(m_appsrc);
+    ASSERT_EQ(feeder.push(std::move(buffer)), GstFeedResult::stopped);
+    ASSERT_TRUE(buffer);
+}
+
+TEST_F(GstAppSrcFeederTest, seek_drops_pending) {
+    GstAppSrcFeeder feeder{m_element, {}, 4};
+    guint64 seekOffset = 0;
+    feeder.onSeek([&seekOffset](guint64 offset) {
+        seekOffset = offset;
+        return true;
+    });
+    enoughData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(0)), GstFeedResult::accepted);
+    ASSERT_EQ(feeder.push(numbered(1)), GstFeedResult::accepted);
+
+    g_buffersFreed = 0;
+    ASSERT_EQ(m_appsrc->m_callbacks.seek_data(m_appsrc, 4096, m_appsrc->m_userData),
+              TRUE);
+    ASSERT_EQ(seekOffset, 4096);
+    ASSERT_EQ(g_buffersFreed, 2);
+    ASSERT_EQ(feeder.stats().pendingBuffers, 0);
+
+    needData(m_appsrc);
+    ASSERT_EQ(feeder.push(numbered(2)), GstFeedResult::accepted);
+    ASSERT_EQ(m_appsrc->pushed(), (std::vector<int>{2}));
+}
+
+TEST_F(GstAppSrcFeederTest, ready_on_need_data) {
+    GstAppSrcFeeder feeder{m_element, {}};
+    int ready = 0;
+    feeder.onReady([&ready] { ++ready; });
+    needData(m_appsrc);
+    needData(m_appsrc);
+    ASSERT_EQ(ready, 2);
+}
+
+TEST_F(GstAppSrcFeederTest, flow_error) {
+    GstAppSrcFeeder feeder{m_element, {}};
+    m_appsrc->m_flow = GST_FLOW_FLUSHING;
+    ASSERT_EQ(feeder.push(numbered(0)), GstFeedResult::flowError);
+}
+
+TEST_F(GstAppSrcFeederTest, removes_callbacks) {
+    {
+        GstAppSrcFeeder feeder{m_element, {}};
+        ASSERT_EQ(m_appsrc->m_userData, &feeder);
+    }
+    ASSERT_EQ(m_appsrc->m_userData, nullptr);
+    ASSERT_EQ(m_appsrc->m_callbacks.need_data, nullptr);
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include "../gst_ptr_byte_scan.h"
+
+#include <vector>
+
+// The scans don't need GStreamer: they work over plain memory.
+
+TEST(ByteScan, start_code_found) {
+    const std::vector<std::uint8_t> data{0x12, 0x00, 0x00, 0x01, 0x65, 0x88};
+    ASSERT_EQ(findStartCode(data.data(), data.size()), 1);
+}
+
+TEST(ByteScan, start_code_after_false_candidates) {
+    const std::vector<std::uint8_t> data{0x00, 0x01, 0x00, 0x00, 0x00,
+                                         0x00, 0x01, 0x09, 0xF0};
+    ASSERT_EQ(findStartCode(data.data(), data.size()), 4);
+}
+
+TEST(ByteScan, start_code_not_found) {
+    const std::vector<std::uint8_t> data{0x00, 0x00, 0x02, 0x00, 0x00, 0x01};
+    // A start code needs the byte after the prefix, like GstAdapter's scans
+    ASSERT_EQ(findStartCode(data.data(), data.size()), -1);
+}
+
+TEST(ByteScan, too_small) {
+    const std::vector<std::uint8_t> data{0x00, 0x00, 0x01};
+    ASSERT_EQ(findStartCode(data.data(), data.size()), -1);
+    ASSERT_EQ(findStartCode(nullptr, 0), -1);
+}
+
+TEST(ByteScan, masked_scan_full_mask) {
+    const std::vector<std::uint8_t> data{0x47, 0x47, 0x1F, 0xFF, 0x10, 0x00};
+    ASSERT_EQ(maskedScanUint32(data.data(), data.size(), 0xFFFFFFFF, 0x471FFF10), 1);
+}
+
+TEST(ByteScan, masked_scan_partial_first_byte) {
+    // The first byte is not fully masked: the rolling path is used
+    const std::vector<std::uint8_t> data{0x12, 0x34, 0xFF, 0xF1, 0x50, 0x80};
+    ASSERT_EQ(maskedScanUint32(data.data(), data.size(), 0xFFF60000, 0xFFF00000), 2);
+    ASSERT_EQ(maskedScanUint32(data.data(), data.size(), 0x0F000000, 0x04000000), 1);
+}
+
+TEST(ByteScan, masked_scan_last_position) {
+    const std::vector<std::uint8_t> data{0x00, 0x00, 0xAA, 0xBB, 0xCC, 0xDD};
+    ASSERT_EQ(maskedScanUint32(data.data(), data.size(), 0xFFFFFFFF, 0xAABBCCDD), 2);
+    ASSERT_EQ(maskedScanUint32(data.data(), data.size(), 0x00FFFFFF, 0x00BBCCDD), 2);
+}
+
+TEST(ByteScan, sync_byte_found) {
+    std::vector<std::uint8_t> data(5 * 188, 0x00);
+    data[3] = 0x47; // false sync
+    for (std::size_t packet = 0; packet < 4; ++packet) {
+        data[10 + packet * 188] = 0x47;
+    }
+    ASSERT_EQ(findSyncByte(data.data(), data.size(), 0x47, 188), 10);
+}
+
+TEST(ByteScan, sync_byte_not_confirmed) {
+    std::vector<std::uint8_t> data(3 * 188, 0x00);
+    data[0] = 0x47;
+    data[188] = 0x47;
+    ASSERT_EQ(findSyncByte(data.data(), data.size(), 0x47, 188), -1);
+}
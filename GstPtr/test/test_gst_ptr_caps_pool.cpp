@@ -0,0 +1,564 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+#include "gst_ptr_dummy_value.h"
+
+//
+// Dummy GstCaps
+// Caps hold structures (a name and fields) and their features. A field is
+// either fixed (int, string, fraction, bitmask...) or an int range, which
+// makes the caps non-fixed. Equality, intersection and fixation follow
+// GStreamer's rules for those types; the tests count how many times they run.
+//
+using GQuark = unsigned int;
+constexpr GType GST_TYPE_FRACTION = 0x140;
+constexpr GType GST_TYPE_INT_RANGE = 0x141;
+// Not hashed by value by the pool, only by its type
+constexpr GType GST_TYPE_BITMASK = 0x142;
+#define G_VALUE_TYPE(value) ((value)->g_type)
+#define GST_MINI_OBJECT_REFCOUNT_VALUE(object) ((object)->m_refCount.load())
+
+// NOLINTNEXTLINE
+GQuark g_quark_from_string(const gchar *name) {
+    static std::map<std::string, GQuark> quarks;
+    return quarks.emplace(name, static_cast<GQuark>(quarks.size() + 1))
+        .first->second;
+}
+
+// NOLINTNEXTLINE
+gint gst_value_get_fraction_numerator(const GValue *value) {
+    return static_cast<gint>(value->v_int);
+}
+// NOLINTNEXTLINE
+gint gst_value_get_fraction_denominator(const GValue *value) {
+    return static_cast<gint>(value->v_uint);
+}
+
+struct GstStructure {
+    GstStructure(const gchar *name,
+                 std::vector<std::pair<const gchar *, GValue>> fields)
+        : name(g_quark_from_string(name)) {
+        for (auto &field : fields) {
+            this->fields.emplace_back(g_quark_from_string(field.first),
+                                      field.second);
+        }
+    }
+    GstStructure(const GstStructure &other)
+        : name(other.name), fields(other.fields) {
+        for (auto &field : fields) {
+            if (field.second.v_string != nullptr) {
+                field.second.v_string = strdup(field.second.v_string);
+            }
+        }
+    }
+    GstStructure &operator=(const GstStructure &) = delete;
+    ~GstStructure() {
+        for (auto &field : fields) {
+            g_value_unset(&field.second);
+        }
+    }
+    const GValue *field(GQuark id) const {
+        for (const auto &field : fields) {
+            if (field.first == id) {
+                return &field.second;
+            }
+        }
+        return nullptr;
+    }
+    GQuark name;
+    std::vector<std::pair<GQuark, GValue>> fields;
+};
+
+struct GstCapsFeatures {
+    std::vector<GQuark> ids;
+};
+
+class TestCaps : public GstCaps {
+public:
+    bool m_any = false;
+    std::vector<GstStructure> m_structures;
+    std::vector<GstCapsFeatures> m_features;
+};
+
+const TestCaps *testCaps(const GstCaps *caps) {
+    return static_cast<const TestCaps *>(caps);
+}
+
+GValue intValue(gint content) {
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, G_TYPE_INT);
+    g_value_set_int(&value, content);
+    return value;
+}
+GValue stringValue(const gchar *content) {
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, G_TYPE_STRING);
+    g_value_set_string(&value, content);
+    return value;
+}
+GValue fractionValue(gint numerator, gint denominator) {
+    return GValue{GST_TYPE_FRACTION, numerator,
+                  static_cast<guint64>(denominator), 0.0, nullptr};
+}
+GValue rangeValue(gint minimum, gint maximum) {
+    return GValue{GST_TYPE_INT_RANGE, minimum, static_cast<guint64>(maximum),
+                  0.0, nullptr};
+}
+GValue bitmaskValue(guint64 mask) {
+    return GValue{GST_TYPE_BITMASK, 0, mask, 0.0, nullptr};
+}
+
+bool valuesEqual(const GValue &first, const GValue &second) {
+    if (first.g_type != second.g_type) {
+        return false;
+    }
+    if (first.g_type == GST_TYPE_FRACTION) {
+        return first.v_int * static_cast<gint64>(second.v_uint) ==
+               second.v_int * static_cast<gint64>(first.v_uint);
+    }
+    if (first.g_type == G_TYPE_STRING) {
+        return std::strcmp(first.v_string, second.v_string) == 0;
+    }
+    return first.v_int == second.v_int && first.v_uint == second.v_uint;
+}
+
+bool structuresEqual(const GstStructure &first, const GstStructure &second) {
+    if (first.name != second.name ||
+        first.fields.size() != second.fields.size()) {
+        return false;
+    }
+    return std::all_of(first.fields.begin(), first.fields.end(),
+                       [&](const auto &field) {
+                           const GValue *other = second.field(field.first);
+                           return other != nullptr &&
+                                  valuesEqual(field.second, *other);
+                       });
+}
+
+bool featuresEqual(const GstCapsFeatures &first, const GstCapsFeatures &second) {
+    auto firstIds = first.ids;
+    auto secondIds = second.ids;
+    std::sort(firstIds.begin(), firstIds.end());
+    std::sort(secondIds.begin(), secondIds.end());
+    return firstIds == secondIds;
+}
+
+/// Fields present in both must have a common value
+std::optional<GValue> intersectValues(const GValue &first,
+                                      const GValue &second) {
+    if (first.g_type == GST_TYPE_INT_RANGE &&
+        second.g_type == GST_TYPE_INT_RANGE) {
+        const gint64 minimum = std::max(first.v_int, second.v_int);
+        const gint64 maximum = static_cast<gint64>(
+            std::min(first.v_uint, second.v_uint));
+        if (minimum > maximum) {
+            return std::nullopt;
+        }
+        return rangeValue(static_cast<gint>(minimum), static_cast<gint>(maximum));
+    }
+    if (first.g_type == GST_TYPE_INT_RANGE || second.g_type == GST_TYPE_INT_RANGE) {
+        const GValue &range = first.g_type == GST_TYPE_INT_RANGE ? first : second;
+        const GValue &fixed = first.g_type == GST_TYPE_INT_RANGE ? second : first;
+        if (fixed.g_type == G_TYPE_INT && fixed.v_int >= range.v_int &&
+            fixed.v_int <= static_cast<gint64>(range.v_uint)) {
+            return fixed;
+        }
+        return std::nullopt;
+    }
+    if (valuesEqual(first, second)) {
+        return first;
+    }
+    return std::nullopt;
+}
+
+int g_intersections = 0;
+int g_canIntersections = 0;
+int g_fixations = 0;
+
+// NOLINTNEXTLINE
+gboolean gst_caps_is_any(const GstCaps *caps) { return testCaps(caps)->m_any; }
+// NOLINTNEXTLINE
+gboolean gst_caps_is_empty(const GstCaps *caps) {
+    return !testCaps(caps)->m_any && testCaps(caps)->m_structures.empty();
+}
+// NOLINTNEXTLINE
+gboolean gst_caps_is_fixed(const GstCaps *caps) {
+    const auto &structures = testCaps(caps)->m_structures;
+    return structures.size() == 1 &&
+           std::none_of(structures[0].fields.begin(), structures[0].fields.end(),
+                        [](const auto &field) {
+                            return field.second.g_type == GST_TYPE_INT_RANGE;
+                        });
+}
+// NOLINTNEXTLINE
+guint gst_caps_get_size(const GstCaps *caps) {
+    return static_cast<guint>(testCaps(caps)->m_structures.size());
+}
+// NOLINTNEXTLINE
+GstStructure *gst_caps_get_structure(const GstCaps *caps, guint index) {
+    return const_cast<GstStructure *>(&testCaps(caps)->m_structures[index]);
+}
+// NOLINTNEXTLINE
+GstCapsFeatures *gst_caps_get_features(const GstCaps *caps, guint index) {
+    return const_cast<GstCapsFeatures *>(&testCaps(caps)->m_features[index]);
+}
+// NOLINTNEXTLINE
+guint gst_caps_features_get_size(const GstCapsFeatures *features) {
+    return static_cast<guint>(features->ids.size());
+}
+// NOLINTNEXTLINE
+GQuark gst_caps_features_get_nth_id(const GstCapsFeatures *features,
+                                    guint index) {
+    return features->ids[index];
+}
+// NOLINTNEXTLINE
+GQuark gst_structure_get_name_id(const GstStructure *structure) {
+    return structure->name;
+}
+using GstStructureForeachFunc = gboolean (*)(GQuark, const GValue *, gpointer);
+// NOLINTNEXTLINE
+gboolean gst_structure_foreach(const GstStructure *structure,
+                               GstStructureForeachFunc function,
+                               gpointer userData) {
+    for (const auto &field : structure->fields) {
+        if (function(field.first, &field.second, userData) == FALSE) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Every structure of each one has an equal one in the other (enough for the
+// tests, which don't use subsets)
+// NOLINTNEXTLINE
+gboolean gst_caps_is_equal(const GstCaps *first, const GstCaps *second) {
+    const TestCaps *lhs = testCaps(first);
+    const TestCaps *rhs = testCaps(second);
+    if (lhs->m_any || rhs->m_any) {
+        return lhs->m_any == rhs->m_any;
+    }
+    auto contained = [](const TestCaps *caps, const TestCaps *other) {
+        for (std::size_t i = 0; i < caps->m_structures.size(); ++i) {
+            bool found = false;
+            for (std::size_t j = 0; j < other->m_structures.size() && !found; ++j) {
+                found = structuresEqual(caps->m_structures[i],
+                                        other->m_structures[j]) &&
+                        featuresEqual(caps->m_features[i], other->m_features[j]);
+            }
+            if (!found) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return contained(lhs, rhs) && contained(rhs, lhs);
+}
+
+// NOLINTNEXTLINE
+GstCaps *gst_caps_intersect(GstCaps *first, GstCaps *second) {
+    ++g_intersections;
+    auto *result = new TestCaps();
+    const TestCaps *lhs = testCaps(first);
+    const TestCaps *rhs = testCaps(second);
+    for (std::size_t i = 0; i < lhs->m_structures.size(); ++i) {
+        for (std::size_t j = 0; j < rhs->m_structures.size(); ++j) {
+            const GstStructure &a = lhs->m_structures[i];
+            const GstStructure &b = rhs->m_structures[j];
+            if (a.name != b.name ||
+                !featuresEqual(lhs->m_features[i], rhs->m_features[j])) {
+                continue;
+            }
+            GstStructure merged{"", {}};
+            merged.name = a.name;
+            bool compatible = true;
+            for (const auto &field : a.fields) {
+                const GValue *other = b.field(field.first);
+                GValue value = field.second;
+                if (other != nullptr) {
+                    auto common = intersectValues(field.second, *other);
+                    compatible = compatible && common.has_value();
+                    value = common.value_or(field.second);
+                }
+                if (value.v_string != nullptr) {
+                    value.v_string = strdup(value.v_string);
+                }
+                merged.fields.emplace_back(field.first, value);
+            }
+            for (const auto &field : b.fields) {
+                if (a.field(field.first) == nullptr) {
+                    GValue value = field.second;
+                    if (value.v_string != nullptr) {
+                        value.v_string = strdup(value.v_string);
+                    }
+                    merged.fields.emplace_back(field.first, value);
+                }
+            }
+            if (compatible) {
+                result->m_structures.push_back(merged);
+                result->m_features.push_back(lhs->m_features[i]);
+            }
+        }
+    }
+    return result;
+}
+// NOLINTNEXTLINE
+gboolean gst_caps_can_intersect(const GstCaps *first, const GstCaps *second) {
+    ++g_canIntersections;
+    GstCaps *result = gst_caps_intersect(const_cast<GstCaps *>(first),
+                                         const_cast<GstCaps *>(second));
+    --g_intersections;
+    const gboolean empty = gst_caps_is_empty(result);
+    gst_mini_object_unref(result);
+    return empty == FALSE;
+}
+// Keeps the first structure, with ranges fixed to their minimum
+// NOLINTNEXTLINE
+GstCaps *gst_caps_fixate(GstCaps *caps) {
+    ++g_fixations;
+    auto *result = new TestCaps();
+    const TestCaps *source = testCaps(caps);
+    if (!source->m_structures.empty()) {
+        result->m_structures.push_back(source->m_structures[0]);
+        result->m_features.push_back(source->m_features[0]);
+        for (auto &field : result->m_structures[0].fields) {
+            if (field.second.g_type == GST_TYPE_INT_RANGE) {
+                field.second = intValue(static_cast<gint>(field.second.v_int));
+            }
+        }
+    }
+    gst_mini_object_unref(caps);
+    return result;
+}
+
+//
+// The tests
+//
+
+#include "../gst_ptr_caps_pool.h"
+
+/// Caps with a structure per element of \p structures, all with \p features
+GstPtr<GstCaps> makeCaps(std::vector<GstStructure> structures,
+                         std::vector<const gchar *> features = {}) {
+    auto *caps = new TestCaps();
+    GstCapsFeatures capsFeatures;
+    for (const gchar *feature : features) {
+        capsFeatures.ids.push_back(g_quark_from_string(feature));
+    }
+    caps->m_structures = std::move(structures);
+    caps->m_features.assign(caps->m_structures.size(), capsFeatures);
+    return caps;
+}
+
+class GstCapsPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        g_intersections = 0;
+        g_canIntersections = 0;
+        g_fixations = 0;
+    }
+
+    static GstPtr<GstCaps> video(gint width, gint height) {
+        return makeCaps({GstStructure{"video/x-raw",
+                                      {{"format", stringValue("I420")},
+                                       {"width", intValue(width)},
+                                       {"height", intValue(height)},
+                                       {"framerate", fractionValue(30, 1)}}}});
+    }
+    static GstPtr<GstCaps> videoRange(gint minimum, gint maximum) {
+        return makeCaps({GstStructure{
+            "video/x-raw", {{"width", rangeValue(minimum, maximum)}}}});
+    }
+
+    GstCapsPool m_pool;
+};
+
+TEST_F(GstCapsPoolTest, equal_caps_written_differently) {
+    GstInternedCaps first = m_pool.intern(video(320, 240));
+    // Other field order, and an equivalent framerate
+    GstPtr<GstCaps> reordered = makeCaps({GstStructure{
+        "video/x-raw",
+        {{"framerate", fractionValue(60, 2)},
+         {"height", intValue(240)},
+         {"format", stringValue("I420")},
+         {"width", intValue(320)}}}});
+    ASSERT_EQ(detail::hashCaps(first.self()), detail::hashCaps(reordered.self()));
+    GstInternedCaps second = m_pool.intern(reordered);
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(second.self(), first.self());
+    ASSERT_NE(second.self(), reordered.self());
+    ASSERT_EQ(m_pool.size(), 1U);
+}
+
+TEST_F(GstCapsPoolTest, unequal_caps_are_distinct) {
+    GstInternedCaps small = m_pool.intern(video(320, 240));
+    GstInternedCaps large = m_pool.intern(video(640, 480));
+    ASSERT_NE(small, large);
+    GstInternedCaps dmabuf = m_pool.intern(makeCaps(
+        {GstStructure{"video/x-raw",
+                      {{"format", stringValue("I420")},
+                       {"width", intValue(320)},
+                       {"height", intValue(240)},
+                       {"framerate", fractionValue(30, 1)}}}},
+        {"memory:DMABuf"}));
+    ASSERT_NE(small, dmabuf);
+    ASSERT_EQ(m_pool.size(), 3U);
+}
+
+TEST_F(GstCapsPoolTest, hash_collisions_stay_distinct) {
+    // Non-fixed caps are only hashed by their names
+    GstPtr<GstCaps> narrow = videoRange(1, 100);
+    GstPtr<GstCaps> wide = videoRange(1, 200);
+    ASSERT_EQ(detail::hashCaps(narrow.self()), detail::hashCaps(wide.self()));
+    // Values of types the pool doesn't know are only hashed by type
+    GstPtr<GstCaps> low = makeCaps(
+        {GstStructure{"audio/x-raw", {{"channel-mask", bitmaskValue(0x3)}}}});
+    GstPtr<GstCaps> high = makeCaps(
+        {GstStructure{"audio/x-raw", {{"channel-mask", bitmaskValue(0xC)}}}});
+    ASSERT_EQ(detail::hashCaps(low.self()), detail::hashCaps(high.self()));
+
+    for (const auto &caps : {narrow, wide, low, high}) {
+        ASSERT_EQ(m_pool.intern(caps).self(), caps.self());
+    }
+    ASSERT_EQ(m_pool.size(), 4U);
+    // And each one is still found in its bucket
+    ASSERT_EQ(m_pool.intern(videoRange(1, 200)).self(), wide.self());
+    ASSERT_EQ(m_pool.intern(makeCaps({GstStructure{
+                                "audio/x-raw",
+                                {{"channel-mask", bitmaskValue(0xC)}}}}))
+                  .self(),
+              high.self());
+}
+
+TEST_F(GstCapsPoolTest, any_empty_and_null) {
+    auto *any = new TestCaps();
+    any->m_any = true;
+    GstInternedCaps first = m_pool.intern(GstPtr<GstCaps>{any});
+    GstPtr<GstCaps> otherAny = new TestCaps();
+    static_cast<TestCaps *>(otherAny.self())->m_any = true;
+    ASSERT_EQ(m_pool.intern(otherAny), first);
+    GstInternedCaps empty = m_pool.intern(makeCaps({}));
+    ASSERT_NE(empty, first);
+    ASSERT_EQ(m_pool.intern(makeCaps({})), empty);
+    ASSERT_FALSE(m_pool.intern(GstPtr<GstCaps>{}));
+}
+
+TEST_F(GstCapsPoolTest, intern_counters) {
+    GstPtr<GstCaps> caps = video(320, 240);
+    (void)m_pool.intern(caps);
+    (void)m_pool.intern(caps);
+    (void)m_pool.intern(video(320, 240));
+    (void)m_pool.intern(video(640, 480));
+    const GstCapsPool::Stats stats = m_pool.stats();
+    ASSERT_EQ(stats.internHits, 2U);
+    ASSERT_EQ(stats.internMisses, 2U);
+    ASSERT_DOUBLE_EQ(stats.internHitRate(), 0.5);
+    ASSERT_EQ(stats.memoHits + stats.memoMisses, 0U);
+    ASSERT_DOUBLE_EQ(stats.memoHitRate(), 0.0);
+}
+
+TEST_F(GstCapsPoolTest, intersect_is_memoized) {
+    GstInternedCaps range = m_pool.intern(videoRange(100, 400));
+    GstInternedCaps fixed = m_pool.intern(makeCaps(
+        {GstStructure{"video/x-raw", {{"width", intValue(320)}}}}));
+    GstInternedCaps common = m_pool.intersect(range, fixed);
+    ASSERT_EQ(common, fixed);
+    ASSERT_EQ(m_pool.intersect(range, fixed), common);
+    ASSERT_EQ(g_intersections, 1);
+
+    ASSERT_TRUE(m_pool.canIntersect(range, fixed));
+    ASSERT_TRUE(m_pool.canIntersect(range, fixed));
+    ASSERT_EQ(g_canIntersections, 1);
+    GstInternedCaps other = m_pool.intern(videoRange(500, 600));
+    ASSERT_FALSE(m_pool.canIntersect(range, other));
+    ASSERT_FALSE(m_pool.canIntersect(range, other));
+    ASSERT_EQ(g_canIntersections, 2);
+    // The same caps don't need the memo
+    ASSERT_TRUE(m_pool.canIntersect(range, range));
+    ASSERT_EQ(g_canIntersections, 2);
+
+    const GstCapsPool::Stats stats = m_pool.stats();
+    ASSERT_EQ(stats.memoHits, 3U);
+    ASSERT_EQ(stats.memoMisses, 3U);
+}
+
+TEST_F(GstCapsPoolTest, fixate_is_memoized) {
+    GstPtr<GstCaps> caps = videoRange(100, 400);
+    GstInternedCaps range = m_pool.intern(caps);
+    GstInternedCaps fixed = m_pool.fixate(range);
+    ASSERT_EQ(fixed, m_pool.intern(makeCaps({GstStructure{
+                         "video/x-raw", {{"width", intValue(100)}}}})));
+    ASSERT_EQ(m_pool.fixate(range), fixed);
+    ASSERT_EQ(g_fixations, 1);
+    // The interned caps were copied, not fixated in place
+    ASSERT_EQ(testCaps(caps.self())->m_structures[0].fields[0].second.g_type,
+              GST_TYPE_INT_RANGE);
+}
+
+TEST_F(GstCapsPoolTest, memo_lru_eviction) {
+    std::vector<GstPtr<GstCaps>> candidates;
+    for (gint i = 0; i < 256; ++i) {
+        candidates.push_back(videoRange(i, 1000));
+    }
+    // Memo entries are spread among shards, each one with its own LRU. With
+    // a single entry per shard, caps whose fixate() evicts the one of the
+    // first candidate share its shard.
+    GstCapsPool probe{1};
+    std::vector<GstInternedCaps> sameShard{probe.intern(candidates[0])};
+    for (std::size_t i = 1; i < candidates.size() && sameShard.size() < 3; ++i) {
+        GstInternedCaps candidate = probe.intern(candidates[i]);
+        (void)probe.fixate(sameShard[0]);
+        (void)probe.fixate(candidate);
+        const std::uint64_t misses = probe.stats().memoMisses;
+        (void)probe.fixate(sameShard[0]);
+        if (probe.stats().memoMisses != misses) {
+            sameShard.push_back(candidate);
+        }
+    }
+    ASSERT_EQ(sameShard.size(), 3U);
+
+    // Two entries per shard (16 shards)
+    GstCapsPool pool{2 * 16};
+    GstInternedCaps first = pool.intern(sameShard[0].caps());
+    GstInternedCaps second = pool.intern(sameShard[1].caps());
+    GstInternedCaps third = pool.intern(sameShard[2].caps());
+    g_fixations = 0;
+    (void)pool.fixate(first);
+    (void)pool.fixate(second);
+    (void)pool.fixate(first); // first is now the most recently used
+    (void)pool.fixate(third); // evicts second
+    ASSERT_EQ(g_fixations, 3);
+    (void)pool.fixate(first);
+    (void)pool.fixate(third);
+    ASSERT_EQ(g_fixations, 3);
+    (void)pool.fixate(second);
+    ASSERT_EQ(g_fixations, 4);
+}
+
+TEST_F(GstCapsPoolTest, purge_keeps_referenced_caps) {
+    GstInternedCaps kept = m_pool.intern(video(320, 240));
+    GstPtr<GstCaps> external = video(640, 480);
+    (void)m_pool.intern(external);
+    (void)m_pool.intern(video(1280, 720));
+    GstInternedCaps range = m_pool.intern(videoRange(1, 100));
+    // Only referenced by the memo: dropped with it
+    (void)m_pool.fixate(range);
+    range = GstInternedCaps{};
+    ASSERT_EQ(m_pool.size(), 5U);
+
+    m_pool.purgeUnused();
+    ASSERT_EQ(m_pool.size(), 2U);
+    ASSERT_EQ(GST_MINI_OBJECT_REFCOUNT_VALUE(kept.self()), 2);
+    ASSERT_EQ(m_pool.intern(video(320, 240)), kept);
+    ASSERT_EQ(m_pool.intern(video(640, 480)).self(), external.self());
+    // Dropped caps are interned anew
+    GstPtr<GstCaps> hd = video(1280, 720);
+    ASSERT_EQ(m_pool.intern(hd).self(), hd.self());
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <cassert>
+#include <type_traits>
+
+// Note: tests have to be run with valgrind, in order to catch leaks.
+
+#include "gst_ptr_dummy.h"
+
+//
+// The C API described by gir/Sample-1.0.gir.
+// gst_ptr_gir_sample.h is generated from that .gir at build time.
+//
+constexpr GType SAMPLE_TYPE_REGION = 0x10;
+
+struct SampleWidget : public GstElement {
+    GstBuffer *buffer = nullptr;
+    GstCaps *caps = new GstCaps();
+    guint size = 0;
+    ~SampleWidget() override {
+        if (buffer != nullptr) {
+            gst_mini_object_unref(buffer);
+        }
+        gst_mini_object_unref(caps);
+    }
+};
+struct SampleSource : public SampleWidget {};
+struct SampleConfigurable : public GObject {};
+class SampleFrame : public GstMiniObject {};
+struct SampleCounter : public GTypeInstance {};
+struct SampleRegion {
+    guint width;
+};
+
+int g_regionsFreed = 0;
+
+// NOLINTNEXTLINE
+void g_boxed_free(GType type, gpointer boxed) {
+    assert(type == SAMPLE_TYPE_REGION);
+    delete static_cast<SampleRegion *>(boxed);
+    ++g_regionsFreed;
+}
+
+// NOLINTNEXTLINE
+GType sample_widget_get_type() { return 0x11; }
+// NOLINTNEXTLINE
+GType sample_source_get_type() { return 0x12; }
+// NOLINTNEXTLINE
+GType sample_configurable_get_type() { return 0x13; }
+// NOLINTNEXTLINE
+GType sample_frame_get_type() { return 0x14; }
+// NOLINTNEXTLINE
+GType sample_counter_get_type() { return 0x15; }
+// NOLINTNEXTLINE
+GType sample_region_get_type() { return SAMPLE_TYPE_REGION; }
+
+// NOLINTNEXTLINE
+SampleWidget *sample_widget_new() {
+    auto *widget = new SampleWidget();
+    widget->m_floating = true;
+    return widget;
+}
+// NOLINTNEXTLINE
+GstBuffer *sample_widget_get_buffer(SampleWidget *widget) { return widget->buffer; }
+// NOLINTNEXTLINE
+gboolean sample_widget_take_buffer(SampleWidget *widget, GstBuffer *buffer) {
+    if (widget->buffer != nullptr) {
+        gst_mini_object_unref(widget->buffer);
+    }
+    widget->buffer = buffer;
+    return TRUE;
+}
+// NOLINTNEXTLINE
+GstCaps *sample_widget_dup_caps(const SampleWidget *widget) {
+    gst_mini_object_ref(widget->caps);
+    return widget->caps;
+}
+// NOLINTNEXTLINE
+const GstCaps *sample_widget_peek_caps(const SampleWidget *widget) { return widget->caps; }
+// NOLINTNEXTLINE
+void sample_widget_set_size(SampleWidget *widget, guint size) { widget->size = size; }
+// NOLINTNEXTLINE
+guint sample_widget_get_size(SampleWidget *widget) { return widget->size; }
+// NOLINTNEXTLINE
+void sample_widget_get_geometry(SampleWidget *, guint *) {}
+// NOLINTNEXTLINE
+void sample_widget_configure(SampleWidget *, ...) {}
+// NOLINTNEXTLINE
+SampleSource *sample_source_make(const gchar *) {
+    auto *source = new SampleSource();
+    source->m_floating = true;
+    return source;
+}
+// NOLINTNEXTLINE
+gboolean sample_widget_attach(GstBin *, SampleWidget *) { return TRUE; }
+// NOLINTNEXTLINE
+SampleFrame *sample_frame_new() { return new SampleFrame(); }
+// NOLINTNEXTLINE
+SampleCounter *sample_counter_new() { return new SampleCounter(); }
+// NOLINTNEXTLINE
+SampleCounter *sample_counter_ref(SampleCounter *counter) {
+    counter->ref();
+    return counter;
+}
+// NOLINTNEXTLINE
+void sample_counter_unref(SampleCounter *counter) {
+    if (counter->unref() == 0) {
+        delete counter;
+    }
+}
+// NOLINTNEXTLINE
+SampleRegion *sample_region_new(guint width) { return new SampleRegion{width}; }
+
+//
+// The tests
+//
+
+#include "gst_ptr_gir_sample.h"
+
+TEST(GstPtrGir, floating_constructor_is_sunk) {
+    GstPtr<SampleWidget> widget = gir::sample_widget_new();
+    ASSERT_FALSE(widget->m_floating);
+    ASSERT_EQ(widget->m_refCount, 1);
+
+    GstPtr<SampleSource> source = gir::sample_source_make("source");
+    ASSERT_FALSE(source->m_floating);
+    ASSERT_EQ(source->m_refCount, 1);
+}
+
+TEST(GstPtrGir, transfer_full_return) {
+    GstPtr<SampleWidget> widget = gir::sample_widget_new();
+    GstPtr<GstCaps> caps = gir::sample_widget_dup_caps(widget);
+    ASSERT_EQ(caps->m_refCount, 2);
+}
+
+TEST(GstPtrGir, transfer_none_return) {
+    GstPtr<SampleWidget> widget = gir::sample_widget_new();
+    GstPtrView<GstCaps> caps = gir::sample_widget_peek_caps(widget);
+    ASSERT_EQ(caps.self(), widget->caps);
+    ASSERT_EQ(caps->m_refCount, 1);
+    ASSERT_FALSE(gir::sample_widget_get_buffer(widget));
+}
+
+TEST(GstPtrGir, transfer_full_parameter) {
+    GstPtr<SampleWidget> widget = gir::sample_widget_new();
+    GstPtr<GstBuffer> buffer = new GstBuffer();
+    GstBuffer *raw = buffer.self();
+    ASSERT_TRUE(gir::sample_widget_take_buffer(widget, std::move(buffer)));
+    ASSERT_EQ(buffer.self(), nullptr);
+    ASSERT_EQ(gir::sample_widget_get_buffer(widget).self(), raw);
+    ASSERT_EQ(raw->m_refCount, 1);
+}
+
+TEST(GstPtrGir, derived_parameters) {
+    GstPtr<SampleSource> source = gir::sample_source_make("source");
+    gir::sample_widget_set_size(source, 42);
+    ASSERT_EQ(gir::sample_widget_get_size(source), 42);
+
+    GstPtr<GstPipeline> pipeline = new GstPipeline();
+    ASSERT_TRUE(gir::sample_widget_attach(pipeline, source));
+    ASSERT_EQ(source->m_refCount, 1);
+}
+
+TEST(GstPtrGir, mini_object_and_refcounted) {
+    GstPtr<SampleFrame> frame = gir::sample_frame_new();
+    GstPtr<SampleFrame> frameCopy{frame};
+    ASSERT_EQ(frame->m_refCount, 2);
+
+    GstPtr<SampleCounter> counter = gir::sample_counter_new();
+    GstPtr<SampleCounter> counterCopy{counter};
+    ASSERT_EQ(counter->m_refCount, 2);
+}
+
+TEST(GstPtrGir, boxed_is_move_only) {
+    g_regionsFreed = 0;
+    {
+        GstPtr<SampleRegion> region = gir::sample_region_new(320);
+        GstPtr<SampleRegion> moved{std::move(region)};
+        ASSERT_EQ(moved->width, 320);
+    }
+    ASSERT_EQ(g_regionsFreed, 1);
+}
@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+
+//
+// A GstIterator over a std::vector, which can be told to resync or fail.
+// The vectors keep one reference to each of their objects.
+//
+constexpr GType GST_TYPE_ITERATOR = 0x0F;
+
+struct GValue {
+    GType g_type;
+    GObject *object;
+};
+#define G_VALUE_INIT {0, nullptr}
+#define G_IS_VALUE(value) ((value)->g_type != 0)
+
+// NOLINTNEXTLINE
+void g_value_reset(GValue *value) {
+    if (value->object != nullptr) {
+        g_object_unref(value->object);
+        value->object = nullptr;
+    }
+}
+// NOLINTNEXTLINE
+void g_value_unset(GValue *value) {
+    g_value_reset(value);
+    value->g_type = 0;
+}
+// NOLINTNEXTLINE
+void *g_value_get_object(const GValue *value) { return value->object; }
+
+enum GstIteratorResult {
+    GST_ITERATOR_DONE = 0,
+    GST_ITERATOR_OK = 1,
+    GST_ITERATOR_RESYNC = 2,
+    GST_ITERATOR_ERROR = 3
+};
+
+struct GstIterator {
+    std::vector<GObject *> items;
+    std::size_t position = 0;
+    std::size_t resyncAt = ~std::size_t{0};
+    std::size_t failAt = ~std::size_t{0};
+    int *freed = nullptr;
+};
+
+// NOLINTNEXTLINE
+GstIteratorResult gst_iterator_next(GstIterator *it, GValue *value) {
+    if (it->position == it->resyncAt) {
+        it->resyncAt = ~std::size_t{0};
+        return GST_ITERATOR_RESYNC;
+    }
+    if (it->position == it->failAt) {
+        return GST_ITERATOR_ERROR;
+    }
+    if (it->position == it->items.size()) {
+        return GST_ITERATOR_DONE;
+    }
+    value->g_type = G_TYPE_OBJECT;
+    value->object = it->items[it->position++];
+    g_object_ref(value->object);
+    return GST_ITERATOR_OK;
+}
+// NOLINTNEXTLINE
+void gst_iterator_resync(GstIterator *it) { it->position = 0; }
+// NOLINTNEXTLINE
+void gst_iterator_free(GstIterator *it) {
+    if (it->freed != nullptr) {
+        ++*it->freed;
+    }
+    delete it;
+}
+
+std::vector<GstElement> g_children(8);
+std::vector<GstPad> g_pads(3);
+
+GstIterator *newIterator(std::vector<GObject *> items) {
+    auto *it = new GstIterator();
+    it->items = std::move(items);
+    return it;
+}
+GstIterator *elementsIterator(std::size_t count) {
+    std::vector<GObject *> items;
+    for (std::size_t index = 0; index < count; ++index) {
+        items.push_back(&g_children[index % g_children.size()]);
+    }
+    return newIterator(items);
+}
+GstIterator *padsIterator() {
+    return newIterator({&g_pads[0], &g_pads[1], &g_pads[2]});
+}
+
+// NOLINTNEXTLINE
+GstIterator *gst_bin_iterate_elements(GstBin *) { return elementsIterator(8); }
+// NOLINTNEXTLINE
+GstIterator *gst_bin_iterate_recurse(GstBin *) { return elementsIterator(8); }
+// NOLINTNEXTLINE
+GstIterator *gst_bin_iterate_sinks(GstBin *) { return elementsIterator(1); }
+// NOLINTNEXTLINE
+GstIterator *gst_bin_iterate_sources(GstBin *) { return elementsIterator(1); }
+// NOLINTNEXTLINE
+GstIterator *gst_element_iterate_pads(GstElement *) { return padsIterator(); }
+// NOLINTNEXTLINE
+GstIterator *gst_element_iterate_sink_pads(GstElement *) { return padsIterator(); }
+// NOLINTNEXTLINE
+GstIterator *gst_element_iterate_src_pads(GstElement *) { return padsIterator(); }
+
+//
+// The tests
+//
+
+#include "../gst_ptr_iterator.h"
+
+namespace {
+
+bool noRefsLeft() {
+    return std::all_of(g_children.begin(), g_children.end(),
+                       [](const GstElement &e) { return e.m_refCount == 1; }) &&
+           std::all_of(g_pads.begin(), g_pads.end(),
+                       [](const GstPad &p) { return p.m_refCount == 1; });
+}
+
+GstPipeline g_pipeline;
+
+GstPtr<GstPipeline> makePipeline() {
+    GstPtr<GstPipeline> pipeline;
+    pipeline.transferNone(&g_pipeline);
+    return pipeline;
+}
+
+} // namespace
+
+TEST(GstIteratorRange, range_for) {
+    auto pipeline = makePipeline();
+    std::size_t count = 0;
+    for (GstPtrView<GstElement> element : iterateElements(pipeline)) {
+        ASSERT_EQ(element.self(), &g_children[count]);
+        // Borrowed: only the vector's and the GValue's references
+        ASSERT_EQ(element->m_refCount, 2);
+        ++count;
+    }
+    ASSERT_EQ(count, g_children.size());
+    ASSERT_TRUE(noRefsLeft());
+}
+
+TEST(GstIteratorRange, frees_iterator) {
+    int freed = 0;
+    {
+        GstIteratorRange<GstElement> range{elementsIterator(4)};
+        range.self()->freed = &freed;
+        std::size_t count = std::distance(range.begin(), range.end());
+        ASSERT_EQ(count, 4);
+    }
+    ASSERT_EQ(freed, 1);
+    ASSERT_TRUE(noRefsLeft());
+}
+
+TEST(GstIteratorRange, algorithms_and_owned) {
+    auto pipeline = makePipeline();
+    GstPtr<GstElement> element = staticGstPtrCast<GstElement>(pipeline);
+    GstPtr<GstPad> second;
+    {
+        auto range = iterateSrcPads(element);
+        auto found = std::find_if(range.begin(), range.end(),
+                                  [](GstPtrView<GstPad> pad) {
+                                      return pad.self() == &g_pads[1];
+                                  });
+        ASSERT_NE(found, range.end());
+        second = (*found).owned();
+    }
+    ASSERT_EQ(second->m_refCount, 2);
+    second = GstPtr<GstPad>{};
+    ASSERT_TRUE(noRefsLeft());
+}
+
+TEST(GstIteratorRange, resync_restarts) {
+    auto *it = elementsIterator(4);
+    it->resyncAt = 2;
+    GstIteratorRange<GstElement> range{it};
+    std::vector<GstElement *> visited;
+    for (auto element : range) {
+        visited.push_back(element.self());
+    }
+    ASSERT_EQ(range.resyncs(), 1);
+    std::vector<GstElement *> expected{&g_children[0], &g_children[1],
+                                       &g_children[0], &g_children[1],
+                                       &g_children[2], &g_children[3]};
+    ASSERT_EQ(visited, expected);
+    ASSERT_TRUE(noRefsLeft());
+}
+
+TEST(GstIteratorRange, error_throws) {
+    auto *it = elementsIterator(4);
+    it->failAt = 1;
+    GstIteratorRange<GstElement> range{it};
+    auto position = range.begin();
+    ASSERT_THROW(++position, std::runtime_error);
+}
+
+TEST(GstIteratorRange, move) {
+    GstIteratorRange<GstElement> range{elementsIterator(3)};
+    GstIteratorRange<GstElement> moved{std::move(range)};
+    ASSERT_EQ(range.begin(), range.end());
+    ASSERT_EQ(std::distance(moved.begin(), moved.end()), 3);
+}
+
+TEST(GstIteratorRange, for_each_parallel) {
+    std::atomic<std::size_t> calls{0};
+    forEachParallel(GstIteratorRange<GstElement>{elementsIterator(1000)},
+                    [&calls](GstPtrView<GstElement> element) {
+                        // The reference taken by forEachParallel is held
+                        ASSERT_GE(element->m_refCount, 2);
+                        ++calls;
+                    },
+                    4);
+    ASSERT_EQ(calls, 1000);
+    ASSERT_TRUE(noRefsLeft());
+}
+
+TEST(GstIteratorRange, for_each_parallel_rethrows) {
+    ASSERT_THROW(
+        forEachParallel(GstIteratorRange<GstElement>{elementsIterator(1000)},
+                        [](GstPtrView<GstElement>) {
+                            throw std::logic_error("failed");
+                        },
+                        4),
+        std::logic_error);
+    ASSERT_TRUE(noRefsLeft());
+}
+
+TEST(GstIteratorRange, for_each_parallel_rethrows_first_after_all_end) {
+    std::atomic<int> calls{0};
+    std::atomic<int> running{0};
+    const auto function = [&](GstPtrView<GstElement>) {
+        ++running;
+        if (calls++ == 0) {
+            // Fail while another thread is still inside function
+            while (calls < 2) {
+                std::this_thread::yield();
+            }
+            --running;
+            throw std::logic_error("first");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --running;
+        throw std::runtime_error("later");
+    };
+    ASSERT_THROW(
+        forEachParallel(GstIteratorRange<GstElement>{elementsIterator(1000)},
+                        function, 4),
+        std::logic_error);
+    ASSERT_EQ(running, 0);
+    ASSERT_GE(calls, 2);
+    ASSERT_TRUE(noRefsLeft());
+}
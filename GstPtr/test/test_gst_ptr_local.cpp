@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+
+// Caps counting every ref/unref call
+std::atomic<long> g_refCalls{0};
+std::atomic<long> g_unrefCalls{0};
+
+class CountedCaps : public GstCaps {
+public:
+    void ref() override {
+        ++g_refCalls;
+        GstCaps::ref();
+    }
+    long unref() override {
+        ++g_unrefCalls;
+        return GstCaps::unref();
+    }
+};
+
+//
+// The tests
+//
+
+#include "../gst_ptr_local.h"
+
+namespace {
+
+// Objects outlive the GstPtrs, so the final refcounts can be checked
+GstPtr<GstCaps> borrow(GstCaps &caps) {
+    GstPtr<GstCaps> ptr;
+    ptr.transferNone(&caps);
+    return ptr;
+}
+
+void resetCalls() {
+    g_refCalls = 0;
+    g_unrefCalls = 0;
+}
+
+} // namespace
+
+TEST(GstLocalRef, one_reference_per_thread) {
+    CountedCaps caps;
+    constexpr int THREADS = 8;
+    constexpr int OPERATIONS = 10000;
+    {
+        GstSharedRef<GstCaps> shared{borrow(caps)};
+        resetCalls();
+
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < THREADS; ++thread) {
+            threads.emplace_back([&shared, &caps] {
+                GstLocalRef<GstCaps> local{shared};
+                for (int operation = 0; operation < OPERATIONS; ++operation) {
+                    GstPtrView<GstCaps> view = local.get();
+                    EXPECT_EQ(view.self(), &caps);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(g_refCalls, THREADS);
+        ASSERT_EQ(g_unrefCalls, THREADS);
+    }
+    ASSERT_EQ(caps.m_refCount, 1);
+}
+
+TEST(GstLocalRef, publish_starts_epoch) {
+    GstCaps first;
+    GstCaps second;
+    {
+        GstSharedRef<GstCaps> shared{borrow(first)};
+        GstLocalRef<GstCaps> local{shared};
+        ASSERT_EQ(local.get().self(), &first);
+        ASSERT_EQ(first.m_refCount, 3);
+
+        shared.publish(borrow(second));
+        ASSERT_EQ(shared.epoch(), 1);
+        ASSERT_FALSE(local.isCurrent());
+        // The old object is held until this thread picks up the new one
+        ASSERT_EQ(first.m_refCount, 2);
+
+        ASSERT_EQ(local.get().self(), &second);
+        ASSERT_TRUE(local.isCurrent());
+        ASSERT_EQ(first.m_refCount, 1);
+        ASSERT_EQ(second.m_refCount, 3);
+    }
+    ASSERT_EQ(second.m_refCount, 1);
+}
+
+TEST(GstLocalRef, release) {
+    GstCaps caps;
+    GstSharedRef<GstCaps> shared{borrow(caps)};
+    GstLocalRef<GstCaps> local{shared};
+    ASSERT_EQ(caps.m_refCount, 3);
+
+    local.release();
+    ASSERT_FALSE(local.isCurrent());
+    ASSERT_EQ(caps.m_refCount, 2);
+
+    ASSERT_EQ(local.get().self(), &caps);
+    ASSERT_EQ(caps.m_refCount, 3);
+}
+
+TEST(GstLocalRef, move) {
+    GstCaps caps;
+    GstSharedRef<GstCaps> shared{borrow(caps)};
+    GstLocalRef<GstCaps> local{shared};
+    GstLocalRef<GstCaps> moved{std::move(local)};
+    ASSERT_EQ(caps.m_refCount, 3);
+    ASSERT_TRUE(moved.isCurrent());
+    ASSERT_EQ(moved.get().self(), &caps);
+}
+
+TEST(GstLocalRef, publish_while_reading) {
+    std::vector<GstCaps> objects(64);
+    {
+        GstSharedRef<GstCaps> shared{borrow(objects[0])};
+        std::atomic<bool> done{false};
+
+        std::vector<std::thread> readers;
+        for (int thread = 0; thread < 4; ++thread) {
+            readers.emplace_back([&] {
+                GstLocalRef<GstCaps> local{shared};
+                while (!done) {
+                    GstPtrView<GstCaps> view = local.get();
+                    // Held by, at least, this thread
+                    EXPECT_GE(view->m_refCount, 2);
+                }
+            });
+        }
+        for (std::size_t index = 1; index < objects.size(); ++index) {
+            shared.publish(borrow(objects[index]));
+            std::this_thread::yield();
+        }
+        done = true;
+        for (auto &thread : readers) {
+            thread.join();
+        }
+        ASSERT_EQ(shared.get().self(), &objects.back());
+    }
+    for (const auto &caps : objects) {
+        ASSERT_EQ(caps.m_refCount, 1);
+    }
+}
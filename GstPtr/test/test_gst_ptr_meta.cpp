@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+
+//
+// Dummy GstMeta
+// Buffers keep their metas in the order they were added. As GStreamer, metas
+// are allocated with the size of their GstMetaInfo, init() runs on add (and a
+// failed one releases the meta without free()), free() on remove and when the
+// buffer is freed. copyBuffer() runs the transform functions as
+// gst_buffer_copy_region() does.
+//
+using gsize = std::size_t;
+using GQuark = unsigned int;
+constexpr GType G_TYPE_INVALID = 0;
+constexpr GQuark COPY_QUARK = 1;
+#define GST_META_TRANSFORM_IS_COPY(type) ((type) == COPY_QUARK)
+
+struct GstMetaInfo;
+struct GstMeta {
+    unsigned int flags;
+    const GstMetaInfo *info;
+};
+struct GstMetaTransformCopy {
+    gboolean region;
+    gsize offset;
+    gsize size;
+};
+using GstMetaInitFunction = gboolean (*)(GstMeta *, gpointer, GstBuffer *);
+using GstMetaFreeFunction = void (*)(GstMeta *, GstBuffer *);
+using GstMetaTransformFunction = gboolean (*)(GstBuffer *, GstMeta *,
+                                              GstBuffer *, GQuark, gpointer);
+struct GstMetaInfo {
+    GType api;
+    GType type;
+    gsize size;
+    GstMetaInitFunction init_func;
+    GstMetaFreeFunction free_func;
+    GstMetaTransformFunction transform_func;
+};
+
+class MetaBuffer : public GstBuffer {
+public:
+    ~MetaBuffer() override {
+        for (auto *meta : m_metas) {
+            meta->info->free_func(meta, this);
+            ::operator delete(meta);
+        }
+    }
+    std::vector<GstMeta *> m_metas;
+    bool m_writable = true;
+};
+
+std::vector<std::string> g_apis;
+
+// NOLINTNEXTLINE
+GType gst_meta_api_type_register(const gchar *api, const gchar **) {
+    g_apis.emplace_back(api);
+    return 0x100 + static_cast<GType>(g_apis.size());
+}
+// NOLINTNEXTLINE
+const GstMetaInfo *gst_meta_register(GType api, const gchar *, gsize size,
+                                     GstMetaInitFunction init,
+                                     GstMetaFreeFunction free,
+                                     GstMetaTransformFunction transform) {
+    static std::vector<std::unique_ptr<GstMetaInfo>> registered;
+    registered.push_back(std::make_unique<GstMetaInfo>(
+        GstMetaInfo{api, api + 0x1000, size, init, free, transform}));
+    return registered.back().get();
+}
+// NOLINTNEXTLINE
+GstMeta *gst_buffer_add_meta(GstBuffer *buffer, const GstMetaInfo *info,
+                             gpointer params) {
+    auto *metaBuffer = static_cast<MetaBuffer *>(buffer);
+    if (!metaBuffer->m_writable) {
+        return nullptr;
+    }
+    auto *meta = static_cast<GstMeta *>(::operator new(info->size));
+    meta->flags = 0;
+    meta->info = info;
+    if (info->init_func(meta, params, buffer) == FALSE) {
+        ::operator delete(meta);
+        return nullptr;
+    }
+    metaBuffer->m_metas.push_back(meta);
+    return meta;
+}
+// NOLINTNEXTLINE
+GstMeta *gst_buffer_iterate_meta_filtered(GstBuffer *buffer, gpointer *state,
+                                          GType api) {
+    auto &metas = static_cast<MetaBuffer *>(buffer)->m_metas;
+    auto index = reinterpret_cast<std::size_t>(*state);
+    for (; index < metas.size(); ++index) {
+        if (metas[index]->info->api == api) {
+            *state = reinterpret_cast<gpointer>(index + 1);
+            return metas[index];
+        }
+    }
+    *state = reinterpret_cast<gpointer>(index);
+    return nullptr;
+}
+// NOLINTNEXTLINE
+GstMeta *gst_buffer_get_meta(GstBuffer *buffer, GType api) {
+    gpointer state = nullptr;
+    return gst_buffer_iterate_meta_filtered(buffer, &state, api);
+}
+// NOLINTNEXTLINE
+gboolean gst_buffer_remove_meta(GstBuffer *buffer, GstMeta *meta) {
+    auto *metaBuffer = static_cast<MetaBuffer *>(buffer);
+    auto &metas = metaBuffer->m_metas;
+    for (auto it = metas.begin(); it != metas.end(); ++it) {
+        if (*it == meta) {
+            metas.erase(it);
+            meta->info->free_func(meta, buffer);
+            ::operator delete(meta);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+GstBuffer *copyBuffer(GstBuffer *source, bool region) {
+    auto *copy = new MetaBuffer();
+    GstMetaTransformCopy params{region ? TRUE : FALSE, 0, 0};
+    for (auto *meta : static_cast<MetaBuffer *>(source)->m_metas) {
+        meta->info->transform_func(copy, meta, source, COPY_QUARK, &params);
+    }
+    return copy;
+}
+
+//
+// The tests
+//
+
+#include "../gst_ptr_meta.h"
+
+int g_destroyed = 0;
+
+struct Detections {
+    static constexpr const char *metaName = "TestDetectionsMeta";
+    Detections() = default;
+    Detections(int first, std::string label)
+        : count(first), label(std::move(label)) {}
+    Detections(const Detections &) = default;
+    ~Detections() { ++g_destroyed; }
+    int count = 0;
+    std::string label;
+};
+
+struct Other {
+    static constexpr const char *metaName = "TestOtherMeta";
+    int value = 0;
+};
+
+struct NeedsArgs {
+    static constexpr const char *metaName = "TestNeedsArgsMeta";
+    explicit NeedsArgs(int value) : value(value) {}
+    int value;
+};
+
+struct Throwing {
+    static constexpr const char *metaName = "TestThrowingMeta";
+    explicit Throwing(bool fail) {
+        if (fail) {
+            throw std::runtime_error("Throwing: failed");
+        }
+    }
+    ~Throwing() { ++g_destroyed; }
+};
+
+struct MoveOnly {
+    static constexpr const char *metaName = "TestMoveOnlyMeta";
+    std::unique_ptr<int> value;
+};
+
+struct AnyCopy {
+    static constexpr const char *metaName = "TestAnyCopyMeta";
+    static constexpr GstMetaCopyPolicy copyPolicy = GstMetaCopyPolicy::anyCopy;
+    int value = 0;
+};
+
+struct NeverCopied {
+    static constexpr const char *metaName = "TestNeverCopiedMeta";
+    static constexpr GstMetaCopyPolicy copyPolicy = GstMetaCopyPolicy::never;
+    int value = 0;
+};
+
+class GstCustomMetaTest : public ::testing::Test {
+protected:
+    void SetUp() override { g_destroyed = 0; }
+    GstPtr<GstBuffer> m_buffer = new MetaBuffer();
+};
+
+TEST_F(GstCustomMetaTest, add_get_remove) {
+    Detections *added = addMeta<Detections>(m_buffer, 3, "car");
+    ASSERT_NE(added, nullptr);
+    ASSERT_EQ(added->count, 3);
+    ASSERT_EQ(added->label, "car");
+    ASSERT_EQ(getMeta<Detections>(m_buffer), added);
+    ASSERT_EQ(getMeta<Other>(m_buffer), nullptr);
+
+    ASSERT_TRUE(removeMeta<Detections>(m_buffer));
+    ASSERT_EQ(g_destroyed, 1);
+    ASSERT_EQ(getMeta<Detections>(m_buffer), nullptr);
+    ASSERT_FALSE(removeMeta<Detections>(m_buffer));
+}
+
+TEST_F(GstCustomMetaTest, stored_inline) {
+    Detections *added = addMeta<Detections>(m_buffer);
+    GstMeta *meta = static_cast<MetaBuffer *>(m_buffer.self())->m_metas[0];
+    ASSERT_EQ(meta->info, GstCustomMeta<Detections>::info());
+    ASSERT_EQ(meta->info->api, GstCustomMeta<Detections>::apiType());
+    ASSERT_EQ(meta->info->size,
+              GstCustomMeta<Detections>::DATA_OFFSET + sizeof(Detections));
+    ASSERT_EQ(GstCustomMeta<Detections>::data(meta), added);
+    ASSERT_EQ(GstCustomMeta<Detections>::DATA_OFFSET % alignof(Detections), 0U);
+}
+
+TEST_F(GstCustomMetaTest, registers_once) {
+    const GType api = GstCustomMeta<Other>::apiType();
+    ASSERT_EQ(GstCustomMeta<Other>::apiType(), api);
+    ASSERT_EQ(GstCustomMeta<Other>::info(), GstCustomMeta<Other>::info());
+    ASSERT_EQ(g_apis[static_cast<std::size_t>(api - 0x101)], "TestOtherMetaAPI");
+}
+
+TEST_F(GstCustomMetaTest, iterate_in_order) {
+    addMeta<Detections>(m_buffer, 1, "a");
+    addMeta<Other>(m_buffer);
+    addMeta<Detections>(m_buffer, 2, "b");
+    addMeta<Detections>(m_buffer, 3, "c");
+    std::vector<int> counts;
+    for (Detections &detections : iterateMeta<Detections>(m_buffer)) {
+        counts.push_back(detections.count);
+    }
+    ASSERT_EQ(counts, (std::vector<int>{1, 2, 3}));
+    ASSERT_EQ(iterateMeta<NeedsArgs>(m_buffer).begin(),
+              iterateMeta<NeedsArgs>(m_buffer).end());
+    ASSERT_EQ(iterateMeta<Other>(GstPtr<GstBuffer>{}).begin(),
+              iterateMeta<Other>(GstPtr<GstBuffer>{}).end());
+}
+
+TEST_F(GstCustomMetaTest, destroyed_with_buffer) {
+    addMeta<Detections>(m_buffer);
+    addMeta<Detections>(m_buffer);
+    m_buffer = nullptr;
+    ASSERT_EQ(g_destroyed, 2);
+}
+
+TEST_F(GstCustomMetaTest, not_writable) {
+    static_cast<MetaBuffer *>(m_buffer.self())->m_writable = false;
+    ASSERT_EQ(addMeta<Detections>(m_buffer), nullptr);
+}
+
+TEST_F(GstCustomMetaTest, without_default_constructor) {
+    NeedsArgs *added = addMeta<NeedsArgs>(m_buffer, 7);
+    ASSERT_NE(added, nullptr);
+    ASSERT_EQ(added->value, 7);
+    // Added from C, without constructor arguments: it fails
+    ASSERT_EQ(gst_buffer_add_meta(m_buffer.self(),
+                                  GstCustomMeta<NeedsArgs>::info(), nullptr),
+              nullptr);
+    // But default-constructible structs can
+    GstMeta *meta = gst_buffer_add_meta(m_buffer.self(),
+                                        GstCustomMeta<Other>::info(), nullptr);
+    ASSERT_NE(meta, nullptr);
+    ASSERT_EQ(GstCustomMeta<Other>::data(meta)->value, 0);
+}
+
+TEST_F(GstCustomMetaTest, constructor_exception_propagates) {
+    ASSERT_THROW(addMeta<Throwing>(m_buffer, true), std::runtime_error);
+    ASSERT_EQ(getMeta<Throwing>(m_buffer), nullptr);
+    ASSERT_EQ(g_destroyed, 0);
+    ASSERT_NE(addMeta<Throwing>(m_buffer, false), nullptr);
+}
+
+TEST_F(GstCustomMetaTest, copy_policy_default) {
+    static_assert(detail::MetaCopyPolicyOf<Detections>::value ==
+                  GstMetaCopyPolicy::fullCopy);
+    static_assert(detail::MetaCopyPolicyOf<MoveOnly>::value ==
+                  GstMetaCopyPolicy::never);
+    Detections *original = addMeta<Detections>(m_buffer, 5, "bus");
+    addMeta<MoveOnly>(m_buffer);
+
+    GstPtr<GstBuffer> copy = copyBuffer(m_buffer.self(), false);
+    Detections *copied = getMeta<Detections>(copy);
+    ASSERT_NE(copied, nullptr);
+    ASSERT_NE(copied, original);
+    ASSERT_EQ(copied->count, 5);
+    ASSERT_EQ(copied->label, "bus");
+    ASSERT_EQ(getMeta<MoveOnly>(copy), nullptr);
+
+    GstPtr<GstBuffer> region = copyBuffer(m_buffer.self(), true);
+    ASSERT_EQ(getMeta<Detections>(region), nullptr);
+}
+
+TEST_F(GstCustomMetaTest, copy_policy_explicit) {
+    addMeta<AnyCopy>(m_buffer)->value = 1;
+    addMeta<NeverCopied>(m_buffer)->value = 2;
+
+    GstPtr<GstBuffer> copy = copyBuffer(m_buffer.self(), false);
+    ASSERT_EQ(getMeta<AnyCopy>(copy)->value, 1);
+    ASSERT_EQ(getMeta<NeverCopied>(copy), nullptr);
+
+    GstPtr<GstBuffer> region = copyBuffer(m_buffer.self(), true);
+    ASSERT_EQ(getMeta<AnyCopy>(region)->value, 1);
+    ASSERT_EQ(getMeta<NeverCopied>(region), nullptr);
+}
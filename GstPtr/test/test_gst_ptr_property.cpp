@@ -0,0 +1,365 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+#include "gst_ptr_dummy_value.h"
+
+//
+// Dummy GObject properties
+// A TestObject class with a few properties, and a TestDerived class that
+// overrides "level" (g_object_class_override_property), so the pspec found is
+// a redirect to the one of TestObject. Notifications are recorded, and queued
+// while frozen, as GLib does.
+//
+constexpr GType TEST_TYPE_OBJECT = 0x130;
+constexpr GType TEST_TYPE_DERIVED = 0x131;
+constexpr GType TEST_TYPE_MODE = G_TYPE_ENUM | 0x100;
+
+enum class TestMode { slow = 0, fast = 1 };
+
+struct GObjectClass {
+    void (*set_property)(GObject *, guint, const GValue *, GParamSpec *);
+    void (*get_property)(GObject *, guint, GValue *, GParamSpec *);
+    std::vector<GParamSpec *> properties;
+};
+
+struct IntParamSpec : public GParamSpec {
+    gint minimum = 0;
+    gint maximum = 0;
+};
+struct OverrideParamSpec : public GParamSpec {
+    GParamSpec *overridden = nullptr;
+};
+
+struct TestObject : public GObject {
+    explicit TestObject(GObjectClass *klass) : m_class(klass) {}
+    GObjectClass *const m_class;
+    gint m_level = 0;
+    std::string m_label;
+    gint m_secret = 0;
+    gint m_mode = 0;
+    gint m_lax = 0;
+    int m_frozen = 0;
+    /// Freeze count seen by the last set_property() call
+    int m_frozenOnSet = 0;
+    std::vector<std::string> m_queued;
+    std::vector<std::string> m_notified;
+    /// Param id and pspec of the last set_property() call
+    guint m_setId = 0;
+    GParamSpec *m_setPspec = nullptr;
+    bool m_derivedSet = false;
+};
+
+enum TestProperty : guint {
+    PROP_LEVEL = 1,
+    PROP_LABEL,
+    PROP_SECRET,
+    PROP_EXPLICIT,
+    PROP_FIXED,
+    PROP_READ_ONLY,
+    PROP_MODE,
+    PROP_LAX
+};
+
+#define G_OBJECT_GET_CLASS(object) (static_cast<TestObject *>(object)->m_class)
+
+void g_object_notify_by_pspec(GObject *object, GParamSpec *pspec);
+
+void testSetProperty(GObject *object, guint id, const GValue *value,
+                     GParamSpec *pspec) {
+    auto *test = static_cast<TestObject *>(object);
+    test->m_setId = id;
+    test->m_setPspec = pspec;
+    test->m_frozenOnSet = test->m_frozen;
+    switch (id) {
+    case PROP_LEVEL: test->m_level = g_value_get_int(value); break;
+    case PROP_EXPLICIT: g_object_notify_by_pspec(object, pspec); break;
+    case PROP_LAX: test->m_lax = g_value_get_int(value); break;
+    case PROP_LABEL: test->m_label = g_value_get_string(value); break;
+    case PROP_SECRET: test->m_secret = g_value_get_int(value); break;
+    case PROP_MODE: test->m_mode = g_value_get_enum(value); break;
+    default: break;
+    }
+}
+void testGetProperty(GObject *object, guint id, GValue *value, GParamSpec *) {
+    auto *test = static_cast<TestObject *>(object);
+    switch (id) {
+    case PROP_LEVEL: g_value_set_int(value, test->m_level); break;
+    case PROP_LABEL: g_value_set_string(value, test->m_label.c_str()); break;
+    case PROP_MODE: g_value_set_enum(value, test->m_mode); break;
+    case PROP_READ_ONLY: g_value_set_int(value, 42); break;
+    default: break;
+    }
+}
+// The derived class only has the overridden "level", with its own id
+constexpr guint DERIVED_PROP_LEVEL = 1;
+void derivedSetProperty(GObject *object, guint id, const GValue *value,
+                        GParamSpec *pspec) {
+    static_cast<TestObject *>(object)->m_derivedSet = true;
+    const guint baseId = id == DERIVED_PROP_LEVEL ? guint{PROP_LEVEL} : 0U;
+    testSetProperty(object, baseId, value, pspec);
+    static_cast<TestObject *>(object)->m_setId = id;
+}
+void derivedGetProperty(GObject *object, guint id, GValue *value,
+                        GParamSpec *pspec) {
+    const guint baseId = id == DERIVED_PROP_LEVEL ? guint{PROP_LEVEL} : 0U;
+    testGetProperty(object, baseId, value, pspec);
+}
+
+template <typename Spec = GParamSpec>
+Spec *newPspec(const gchar *name, GType type, GType owner, guint id,
+               guint flags) {
+    auto *pspec = new Spec();
+    pspec->name = name;
+    pspec->value_type = type;
+    pspec->owner_type = owner;
+    pspec->param_id = id;
+    pspec->flags = flags;
+    return pspec;
+}
+
+GObjectClass *testObjectClass() {
+    static GObjectClass *klass = [] {
+        auto *level = newPspec<IntParamSpec>(
+            "level", G_TYPE_INT, TEST_TYPE_OBJECT, PROP_LEVEL, G_PARAM_READWRITE);
+        level->maximum = 10;
+        auto *lax = newPspec<IntParamSpec>(
+            "lax", G_TYPE_INT, TEST_TYPE_OBJECT, PROP_LAX,
+            G_PARAM_READWRITE | G_PARAM_LAX_VALIDATION);
+        lax->maximum = 10;
+        return new GObjectClass{
+            testSetProperty,
+            testGetProperty,
+            {level,
+             newPspec("label", G_TYPE_STRING, TEST_TYPE_OBJECT, PROP_LABEL,
+                      G_PARAM_READWRITE),
+             newPspec("secret", G_TYPE_INT, TEST_TYPE_OBJECT, PROP_SECRET,
+                      G_PARAM_WRITABLE),
+             newPspec("explicit", G_TYPE_INT, TEST_TYPE_OBJECT, PROP_EXPLICIT,
+                      G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY),
+             newPspec("fixed", G_TYPE_INT, TEST_TYPE_OBJECT, PROP_FIXED,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY),
+             newPspec("read-only", G_TYPE_INT, TEST_TYPE_OBJECT,
+                      PROP_READ_ONLY, G_PARAM_READABLE),
+             newPspec("mode", TEST_TYPE_MODE, TEST_TYPE_OBJECT, PROP_MODE,
+                      G_PARAM_READWRITE),
+             lax}};
+    }();
+    return klass;
+}
+
+GObjectClass *testDerivedClass() {
+    static GObjectClass *klass = [] {
+        auto *level = newPspec<OverrideParamSpec>(
+            "level", G_TYPE_INT, TEST_TYPE_DERIVED, DERIVED_PROP_LEVEL,
+            G_PARAM_READWRITE);
+        level->overridden = testObjectClass()->properties[0];
+        return new GObjectClass{derivedSetProperty, derivedGetProperty, {level}};
+    }();
+    return klass;
+}
+
+// NOLINTNEXTLINE
+GParamSpec *g_object_class_find_property(GObjectClass *klass,
+                                         const gchar *name) {
+    for (auto *pspec : klass->properties) {
+        if (std::string{pspec->name} == name) {
+            return pspec;
+        }
+    }
+    return nullptr;
+}
+// NOLINTNEXTLINE
+gpointer g_type_class_peek(GType type) {
+    return type == TEST_TYPE_DERIVED ? testDerivedClass() : testObjectClass();
+}
+// NOLINTNEXTLINE
+GParamSpec *g_param_spec_get_redirect_target(GParamSpec *pspec) {
+    auto *redirect = dynamic_cast<OverrideParamSpec *>(pspec);
+    return redirect != nullptr ? redirect->overridden : nullptr;
+}
+// Clamps ints into range, returning TRUE if the value had to be modified
+// NOLINTNEXTLINE
+gboolean g_param_value_validate(GParamSpec *pspec, GValue *value) {
+    auto *range = dynamic_cast<IntParamSpec *>(pspec);
+    if (range == nullptr) {
+        return FALSE;
+    }
+    const gint64 clamped = std::clamp<gint64>(value->v_int, range->minimum,
+                                              range->maximum);
+    const gboolean modified = clamped != value->v_int ? TRUE : FALSE;
+    value->v_int = clamped;
+    return modified;
+}
+// NOLINTNEXTLINE
+void g_object_notify_by_pspec(GObject *object, GParamSpec *pspec) {
+    auto *test = static_cast<TestObject *>(object);
+    if (test->m_frozen == 0) {
+        test->m_notified.emplace_back(pspec->name);
+    } else if (std::find(test->m_queued.begin(), test->m_queued.end(),
+                         pspec->name) == test->m_queued.end()) {
+        test->m_queued.emplace_back(pspec->name);
+    }
+}
+// NOLINTNEXTLINE
+void g_object_freeze_notify(GObject *object) {
+    ++static_cast<TestObject *>(object)->m_frozen;
+}
+// NOLINTNEXTLINE
+void g_object_thaw_notify(GObject *object) {
+    auto *test = static_cast<TestObject *>(object);
+    if (--test->m_frozen == 0) {
+        test->m_notified.insert(test->m_notified.end(), test->m_queued.begin(),
+                                test->m_queued.end());
+        test->m_queued.clear();
+    }
+}
+
+//
+// The tests
+//
+
+#include "../gst_ptr_property.h"
+
+class GstPropertyTest : public ::testing::Test {
+protected:
+    TestObject *test() const { return static_cast<TestObject *>(m_object.self()); }
+    GstPtr<GObject> m_object = new TestObject(testObjectClass());
+};
+
+TEST_F(GstPropertyTest, set_and_get) {
+    GstProperty<gint> level{m_object, "level"};
+    level.set(7);
+    ASSERT_EQ(test()->m_level, 7);
+    ASSERT_EQ(test()->m_setId, PROP_LEVEL);
+    ASSERT_EQ(level.get(), 7);
+    ASSERT_EQ(test()->m_notified, (std::vector<std::string>{"level"}));
+
+    GstProperty<std::string> label{m_object, "label"};
+    label.set("fast");
+    ASSERT_EQ(label.get(), "fast");
+    ASSERT_EQ(level.object(), m_object.self());
+    ASSERT_EQ(level.pspec(), testObjectClass()->properties[0]);
+}
+
+TEST_F(GstPropertyTest, enum_values) {
+    GstProperty<TestMode> mode{m_object, "mode"};
+    mode.set(TestMode::fast);
+    ASSERT_EQ(test()->m_mode, 1);
+    ASSERT_EQ(mode.get(), TestMode::fast);
+    // Enums can be handled as gint too
+    GstProperty<gint> raw{m_object, "mode"};
+    ASSERT_EQ(raw.get(), 1);
+}
+
+TEST_F(GstPropertyTest, type_mismatch) {
+    ASSERT_THROW((GstProperty<std::string>{m_object, "level"}),
+                 std::invalid_argument);
+    ASSERT_THROW((GstProperty<guint>{m_object, "level"}), std::invalid_argument);
+    ASSERT_THROW((GstProperty<gint>{m_object, "label"}), std::invalid_argument);
+    ASSERT_THROW((GstProperty<gint>{m_object, "missing"}),
+                 std::invalid_argument);
+    ASSERT_THROW((GstProperty<gint>{GstPtr<GObject>{}, "level"}),
+                 std::invalid_argument);
+}
+
+TEST_F(GstPropertyTest, invalid_value_is_not_written) {
+    GstProperty<gint> level{m_object, "level"};
+    level.set(3);
+    test()->m_notified.clear();
+    ASSERT_THROW(level.set(11), std::invalid_argument);
+    ASSERT_THROW(level.set(-1), std::invalid_argument);
+    ASSERT_EQ(test()->m_level, 3);
+    ASSERT_TRUE(test()->m_notified.empty());
+    level.set(10);
+    ASSERT_EQ(test()->m_level, 10);
+}
+
+TEST_F(GstPropertyTest, access_flags) {
+    ASSERT_THROW(GstProperty<gint>(m_object, "fixed").set(1), std::logic_error);
+    ASSERT_THROW(GstProperty<gint>(m_object, "read-only").set(1),
+                 std::logic_error);
+    ASSERT_EQ(GstProperty<gint>(m_object, "read-only").get(), 42);
+    ASSERT_THROW((void)GstProperty<gint>(m_object, "secret").get(),
+                 std::logic_error);
+}
+
+TEST_F(GstPropertyTest, notify_only_readable) {
+    GstProperty<gint>{m_object, "secret"}.set(5);
+    ASSERT_EQ(test()->m_secret, 5);
+    // Explicit notify properties are notified by the object itself, once
+    GstProperty<gint>{m_object, "explicit"}.set(1);
+    ASSERT_EQ(test()->m_notified, (std::vector<std::string>{"explicit"}));
+}
+
+TEST_F(GstPropertyTest, notify_frozen_while_setting) {
+    GstProperty<gint>{m_object, "level"}.set(1);
+    ASSERT_EQ(test()->m_frozenOnSet, 1);
+    GstProperty<gint>{m_object, "explicit"}.set(1);
+    ASSERT_EQ(test()->m_frozenOnSet, 1);
+    ASSERT_EQ(test()->m_frozen, 0);
+    ASSERT_EQ(test()->m_notified,
+              (std::vector<std::string>{"level", "explicit"}));
+}
+
+TEST_F(GstPropertyTest, lax_validation_clamps) {
+    GstProperty<gint> lax{m_object, "lax"};
+    lax.set(11);
+    ASSERT_EQ(test()->m_lax, 10);
+    lax.set(-1);
+    ASSERT_EQ(test()->m_lax, 0);
+    ASSERT_EQ(test()->m_notified, (std::vector<std::string>{"lax", "lax"}));
+}
+
+TEST_F(GstPropertyTest, override_redirects) {
+    GstPtr<GObject> derived = new TestObject(testDerivedClass());
+    auto *object = static_cast<TestObject *>(derived.self());
+    GstProperty<gint> level{derived, "level"};
+    // The class and id of the pspec found, with the overridden pspec
+    ASSERT_EQ(level.pspec(), testObjectClass()->properties[0]);
+    level.set(4);
+    ASSERT_TRUE(object->m_derivedSet);
+    ASSERT_EQ(object->m_setId, DERIVED_PROP_LEVEL);
+    ASSERT_EQ(object->m_setPspec, testObjectClass()->properties[0]);
+    ASSERT_EQ(level.get(), 4);
+    // Validated with the overridden pspec's range
+    ASSERT_THROW(level.set(11), std::invalid_argument);
+    ASSERT_EQ(object->m_notified, (std::vector<std::string>{"level"}));
+}
+
+TEST_F(GstPropertyTest, move) {
+    GstProperty<std::string> label{m_object, "label"};
+    label.set("before");
+    GstProperty<std::string> moved{std::move(label)};
+    moved.set("after");
+    ASSERT_EQ(moved.get(), "after");
+}
+
+TEST_F(GstPropertyTest, batch_notifies_once) {
+    GstProperty<gint> level{m_object, "level"};
+    GstProperty<std::string> label{m_object, "label"};
+    {
+        GstPropertyBatch batch{m_object};
+        batch.set(level, 1).set(level, 2).set(label, "x").set(level, 3);
+        ASSERT_TRUE(test()->m_notified.empty());
+    }
+    ASSERT_EQ(test()->m_level, 3);
+    ASSERT_EQ(test()->m_notified,
+              (std::vector<std::string>{"level", "label"}));
+    ASSERT_EQ(test()->m_frozen, 0);
+}
+
+TEST_F(GstPropertyTest, batch_rejects_other_objects) {
+    GstPtr<GObject> other = new TestObject(testObjectClass());
+    GstProperty<gint> otherLevel{other, "level"};
+    {
+        GstPropertyBatch batch{m_object};
+        ASSERT_THROW(batch.set(otherLevel, 1), std::invalid_argument);
+    }
+    auto *object = static_cast<TestObject *>(other.self());
+    ASSERT_EQ(object->m_level, 0);
+    ASSERT_TRUE(object->m_notified.empty());
+}
@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gst_ptr_dummy.h"
+#include "gst_ptr_dummy_value.h"
+
+//
+// Dummy GstStructure
+// A structure is a list of (quark, value) fields. Interned names and the
+// fields visited by gst_structure_foreach() are counted. Fractions are a
+// fundamental type, as in GStreamer: the numerator is in v_int and the
+// denominator in v_uint.
+//
+using GQuark = unsigned int;
+constexpr GType GST_TYPE_FRACTION = 0x40;
+constexpr GType TEST_TYPE_MODE = G_TYPE_ENUM | 0x100;
+#define G_VALUE_TYPE(value) ((value)->g_type)
+#define G_UNLIKELY(expression) (expression)
+
+enum class TestMode { slow = 0, fast = 1 };
+
+int internedCount = 0;
+int visitedCount = 0;
+
+// NOLINTNEXTLINE
+GQuark g_quark_from_static_string(const gchar *name) {
+    static std::map<std::string, GQuark> quarks;
+    ++internedCount;
+    return quarks.emplace(name, static_cast<GQuark>(quarks.size() + 1))
+        .first->second;
+}
+
+// NOLINTNEXTLINE
+void gst_value_set_fraction(GValue *value, gint numerator, gint denominator) {
+    value->v_int = numerator;
+    value->v_uint = static_cast<guint64>(denominator);
+}
+// NOLINTNEXTLINE
+gint gst_value_get_fraction_numerator(const GValue *value) {
+    return static_cast<gint>(value->v_int);
+}
+// NOLINTNEXTLINE
+gint gst_value_get_fraction_denominator(const GValue *value) {
+    return static_cast<gint>(value->v_uint);
+}
+
+struct GstStructure {
+    GstStructure() = default;
+    GstStructure(const GstStructure &) = delete;
+    GstStructure &operator=(const GstStructure &) = delete;
+    ~GstStructure() {
+        for (auto &field : fields) {
+            g_value_unset(&field.second);
+        }
+    }
+    std::vector<std::pair<GQuark, GValue>> fields;
+};
+
+class TestCaps : public GstCaps {
+public:
+    std::vector<GstStructure> m_structures = std::vector<GstStructure>(2);
+};
+class TestEvent : public GstEvent {
+public:
+    GstStructure m_structure;
+};
+
+// NOLINTNEXTLINE
+const GValue *gst_structure_id_get_value(const GstStructure *structure,
+                                         GQuark field) {
+    for (const auto &entry : structure->fields) {
+        if (entry.first == field) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+// NOLINTNEXTLINE
+void gst_structure_id_take_value(GstStructure *structure, GQuark field,
+                                 GValue *value) {
+    assert(G_IS_VALUE(value));
+    for (auto &entry : structure->fields) {
+        if (entry.first == field) {
+            g_value_unset(&entry.second);
+            entry.second = *value;
+            return;
+        }
+    }
+    structure->fields.emplace_back(field, *value);
+}
+using GstStructureForeachFunc = gboolean (*)(GQuark, const GValue *, gpointer);
+// NOLINTNEXTLINE
+gboolean gst_structure_foreach(const GstStructure *structure,
+                               GstStructureForeachFunc function,
+                               gpointer userData) {
+    for (const auto &field : structure->fields) {
+        ++visitedCount;
+        if (function(field.first, &field.second, userData) == FALSE) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+// NOLINTNEXTLINE
+GstStructure *gst_caps_get_structure(const GstCaps *caps, guint index) {
+    return &const_cast<TestCaps *>(static_cast<const TestCaps *>(caps))
+                ->m_structures[index];
+}
+// NOLINTNEXTLINE
+const GstStructure *gst_event_get_structure(GstEvent *event) {
+    return &static_cast<TestEvent *>(event)->m_structure;
+}
+
+//
+// The tests
+//
+
+#include "../gst_ptr_structure.h"
+
+namespace {
+
+const GstField<gint> widthField{"width"};
+const GstField<guint> flagsField{"flags"};
+const GstField<gint64> offsetField{"offset"};
+const GstField<guint64> durationField{"duration"};
+const GstField<gdouble> rateField{"rate"};
+const GstField<bool> liveField{"live"};
+const GstField<const gchar *> formatField{"format"};
+const GstField<std::string> formatCopyField{"format"};
+const GstField<GstFieldFraction> framerateField{"framerate"};
+const GstField<TestMode> modeField{"mode", TEST_TYPE_MODE};
+const GstField<gint> modeAsIntField{"mode"};
+
+} // namespace
+
+TEST(GstFieldTest, set_and_get) {
+    GstStructure structure;
+    widthField.set(&structure, 1920);
+    flagsField.set(&structure, 5U);
+    offsetField.set(&structure, -3);
+    durationField.set(&structure, 40000000U);
+    rateField.set(&structure, 0.5);
+    liveField.set(&structure, true);
+    formatField.set(&structure, "NV12");
+    framerateField.set(&structure, {30000, 1001});
+
+    ASSERT_EQ(widthField.get(&structure), 1920);
+    ASSERT_EQ(flagsField.get(&structure), 5U);
+    ASSERT_EQ(offsetField.get(&structure), -3);
+    ASSERT_EQ(durationField.get(&structure), 40000000U);
+    ASSERT_EQ(rateField.get(&structure), 0.5);
+    ASSERT_EQ(liveField.get(&structure), true);
+    ASSERT_STREQ(*formatField.get(&structure), "NV12");
+    ASSERT_EQ(formatCopyField.get(&structure), "NV12");
+    auto framerate = framerateField.get(&structure);
+    ASSERT_TRUE(framerate.has_value());
+    ASSERT_EQ(framerate->numerator, 30000);
+    ASSERT_EQ(framerate->denominator, 1001);
+
+    ASSERT_EQ(G_VALUE_TYPE(gst_structure_id_get_value(&structure,
+                                                      widthField.quark())),
+              G_TYPE_INT);
+    ASSERT_EQ(G_VALUE_TYPE(gst_structure_id_get_value(
+                  &structure, framerateField.quark())),
+              GST_TYPE_FRACTION);
+}
+
+TEST(GstFieldTest, set_replaces) {
+    GstStructure structure;
+    formatField.set(&structure, "I420");
+    formatCopyField.set(&structure, std::string("NV12"));
+    ASSERT_EQ(structure.fields.size(), 1U);
+    ASSERT_STREQ(*formatField.get(&structure), "NV12");
+}
+
+TEST(GstFieldTest, missing_or_other_type) {
+    GstStructure structure;
+    ASSERT_FALSE(widthField.get(&structure).has_value());
+    ASSERT_FALSE(widthField.isIn(&structure));
+
+    formatField.set(&structure, "NV12");
+    const GstField<gint> formatAsIntField{"format"};
+    ASSERT_FALSE(formatAsIntField.get(&structure).has_value());
+    ASSERT_FALSE(formatAsIntField.isIn(&structure));
+    ASSERT_TRUE(formatField.isIn(&structure));
+}
+
+TEST(GstFieldTest, enum_values) {
+    GstStructure structure;
+    modeField.set(&structure, TestMode::fast);
+    const GValue *value =
+        gst_structure_id_get_value(&structure, modeField.quark());
+    ASSERT_EQ(G_VALUE_TYPE(value), TEST_TYPE_MODE);
+    ASSERT_EQ(modeField.get(&structure), TestMode::fast);
+    // Enums can be read as gint too
+    ASSERT_EQ(modeAsIntField.get(&structure), 1);
+    // But a gint field isn't an enum
+    widthField.set(&structure, 1);
+    const GstField<TestMode> widthAsModeField{"width", TEST_TYPE_MODE};
+    ASSERT_FALSE(widthAsModeField.get(&structure).has_value());
+}
+
+TEST(GstFieldTest, enum_without_gtype) {
+    GstStructure structure;
+    // GstField<TestMode>{"mode"} doesn't compile: the GType is required, but
+    // it can still be wrong at runtime
+    const GstField<TestMode> invalidField{"mode", G_TYPE_INVALID};
+    ASSERT_THROW(invalidField.set(&structure, TestMode::fast),
+                 std::invalid_argument);
+    const GstField<TestMode> intField{"mode", G_TYPE_INT};
+    ASSERT_THROW(intField.set(&structure, TestMode::fast),
+                 std::invalid_argument);
+    ASSERT_TRUE(structure.fields.empty());
+    // Reading doesn't need the GType
+    modeField.set(&structure, TestMode::fast);
+    ASSERT_EQ(invalidField.get(&structure), TestMode::fast);
+}
+
+TEST(GstFieldTest, quark_interned_once) {
+    const GstField<gint> heightField{"height"};
+    GstStructure structure;
+    const int interned = internedCount;
+    heightField.set(&structure, 1080);
+    ASSERT_EQ(internedCount, interned + 1);
+    ASSERT_EQ(heightField.get(&structure), 1080);
+    ASSERT_TRUE(heightField.isIn(&structure));
+    ASSERT_EQ(internedCount, interned + 1);
+    ASSERT_STREQ(heightField.name(), "height");
+}
+
+TEST(GstFieldTest, read_fields) {
+    GstStructure structure;
+    formatField.set(&structure, "NV12");
+    widthField.set(&structure, 1920);
+    framerateField.set(&structure, {30, 1});
+    rateField.set(&structure, 1.0);
+
+    visitedCount = 0;
+    auto [width, framerate, format] =
+        readFields(&structure, widthField, framerateField, formatField);
+    ASSERT_EQ(width, 1920);
+    ASSERT_EQ(framerate->numerator, 30);
+    ASSERT_STREQ(*format, "NV12");
+    // Stops once every field is found
+    ASSERT_EQ(visitedCount, 3);
+
+    // Missing and mistyped fields are nullopt
+    const GstField<gint> formatAsIntField{"format"};
+    auto [missing, mistyped] =
+        readFields(&structure, durationField, formatAsIntField);
+    ASSERT_FALSE(missing.has_value());
+    ASSERT_FALSE(mistyped.has_value());
+}
+
+TEST(GstFieldTest, borrow_structure) {
+    GstPtr<GstCaps> caps = new TestCaps();
+    auto *test = static_cast<TestCaps *>(caps.self());
+    widthField.set(&test->m_structures[1], 640);
+    ASSERT_EQ(borrowStructure(caps), &test->m_structures[0]);
+    ASSERT_EQ(widthField.get(borrowStructure(caps, 1)), 640);
+
+    GstPtr<GstEvent> event = new TestEvent();
+    ASSERT_EQ(borrowStructure(event),
+              &static_cast<TestEvent *>(event.self())->m_structure);
+}
@@ -0,0 +1,331 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "gst_ptr_dummy.h"
+
+//
+// Dummy gst-video
+// Only what gst_ptr_video_frame.h uses. Formats describe their components as
+// GstVideoFormatInfo does: the plane each one is in, its pixel stride and its
+// subsampling. Buffers own 64 bytes aligned memory, mapped as a whole.
+//
+using gsize = std::size_t;
+using guint8 = std::uint8_t;
+using guint16 = std::uint16_t;
+constexpr guint GST_VIDEO_MAX_PLANES = 4;
+constexpr guint GST_VIDEO_MAX_COMPONENTS = 4;
+
+enum GstMapFlags { GST_MAP_READ = 1, GST_MAP_WRITE = 2, GST_MAP_READWRITE = 3 };
+enum GstVideoFormat { GST_VIDEO_FORMAT_I420 = 2, GST_VIDEO_FORMAT_NV12 = 23 };
+
+struct GstVideoFormatInfo {
+    GstVideoFormat format;
+    guint n_planes;
+    guint n_components;
+    guint plane[GST_VIDEO_MAX_COMPONENTS];
+    gint pixel_stride[GST_VIDEO_MAX_COMPONENTS];
+    guint w_sub[GST_VIDEO_MAX_COMPONENTS];
+    guint h_sub[GST_VIDEO_MAX_COMPONENTS];
+};
+
+const GstVideoFormatInfo I420_INFO{
+    GST_VIDEO_FORMAT_I420, 3, 3, {0, 1, 2}, {1, 1, 1}, {0, 1, 1}, {0, 1, 1}};
+const GstVideoFormatInfo NV12_INFO{
+    GST_VIDEO_FORMAT_NV12, 2, 3, {0, 1, 1}, {1, 2, 2}, {0, 1, 1}, {0, 1, 1}};
+
+struct GstVideoInfo {
+    const GstVideoFormatInfo *finfo;
+    gint width;
+    gint height;
+    gint stride[GST_VIDEO_MAX_PLANES];
+    gsize offset[GST_VIDEO_MAX_PLANES];
+    gsize size;
+};
+
+struct GstVideoFrame {
+    GstVideoInfo info;
+    GstBuffer *buffer;
+    gpointer data[GST_VIDEO_MAX_PLANES];
+};
+
+int g_maps = 0;
+int g_unmaps = 0;
+GstMapFlags g_lastFlags = GST_MAP_READ;
+
+class MemoryBuffer : public GstBuffer {
+public:
+    explicit MemoryBuffer(gsize size)
+        : m_memory(static_cast<std::uint8_t *>(
+              ::operator new(size, std::align_val_t{64}))),
+          m_size(size) {}
+    ~MemoryBuffer() override {
+        ::operator delete(m_memory, std::align_val_t{64});
+    }
+    std::uint8_t *const m_memory;
+    const gsize m_size;
+};
+
+// NOLINTNEXTLINE
+gboolean gst_video_frame_map(GstVideoFrame *frame, const GstVideoInfo *info,
+                             GstBuffer *buffer, GstMapFlags flags) {
+    auto *memory = static_cast<MemoryBuffer *>(buffer);
+    if (memory->m_size < info->size) {
+        return FALSE;
+    }
+    frame->info = *info;
+    frame->buffer = buffer;
+    for (guint plane = 0; plane < info->finfo->n_planes; ++plane) {
+        frame->data[plane] = memory->m_memory + info->offset[plane];
+    }
+    g_lastFlags = flags;
+    ++g_maps;
+    return TRUE;
+}
+// NOLINTNEXTLINE
+void gst_video_frame_unmap(GstVideoFrame *) { ++g_unmaps; }
+// NOLINTNEXTLINE
+gboolean gst_video_info_is_equal(const GstVideoInfo *info,
+                                 const GstVideoInfo *other) {
+    for (guint plane = 0; plane < GST_VIDEO_MAX_PLANES; ++plane) {
+        if (info->stride[plane] != other->stride[plane] ||
+            info->offset[plane] != other->offset[plane]) {
+            return FALSE;
+        }
+    }
+    const bool equal = info->finfo == other->finfo &&
+                       info->width == other->width &&
+                       info->height == other->height && info->size == other->size;
+    return equal ? TRUE : FALSE;
+}
+// NOLINTNEXTLINE
+void gst_video_format_info_component(const GstVideoFormatInfo *info,
+                                     guint plane, gint components[]) {
+    guint found = 0;
+    for (guint component = 0; component < info->n_components; ++component) {
+        if (info->plane[component] == plane) {
+            components[found++] = static_cast<gint>(component);
+        }
+    }
+    for (; found < GST_VIDEO_MAX_COMPONENTS; ++found) {
+        components[found] = -1;
+    }
+}
+
+// As GST_VIDEO_SUB_SCALE(): subsampled sizes are rounded up
+#define DUMMY_SUB_SCALE(scale, value) (-((-(value)) >> (scale)))
+#define GST_VIDEO_FRAME_N_PLANES(frame) ((frame)->info.finfo->n_planes)
+#define GST_VIDEO_FRAME_WIDTH(frame) ((frame)->info.width)
+#define GST_VIDEO_FRAME_HEIGHT(frame) ((frame)->info.height)
+#define GST_VIDEO_FRAME_FORMAT(frame) ((frame)->info.finfo->format)
+#define GST_VIDEO_FRAME_PLANE_STRIDE(frame, plane) ((frame)->info.stride[plane])
+#define GST_VIDEO_FRAME_PLANE_DATA(frame, plane) ((frame)->data[plane])
+#define GST_VIDEO_FRAME_COMP_PSTRIDE(frame, component)                         \
+    ((frame)->info.finfo->pixel_stride[component])
+#define GST_VIDEO_FRAME_COMP_WIDTH(frame, component)                           \
+    DUMMY_SUB_SCALE((frame)->info.finfo->w_sub[component], (frame)->info.width)
+#define GST_VIDEO_FRAME_COMP_HEIGHT(frame, component)                          \
+    DUMMY_SUB_SCALE((frame)->info.finfo->h_sub[component], (frame)->info.height)
+
+// Planes one after the other, each stride * rows bytes
+GstVideoInfo videoInfo(const GstVideoFormatInfo &format, gint width,
+                       gint height, std::initializer_list<gint> strides) {
+    GstVideoInfo info{&format, width, height, {}, {}, 0};
+    guint plane = 0;
+    for (gint stride : strides) {
+        const gint rows = plane == 0 ? height : DUMMY_SUB_SCALE(1, height);
+        info.stride[plane] = stride;
+        info.offset[plane] = info.size;
+        info.size += static_cast<gsize>(stride) * static_cast<gsize>(rows);
+        ++plane;
+    }
+    return info;
+}
+
+//
+// The tests
+//
+
+#include "../gst_ptr_video_frame.h"
+
+class GstMappedVideoFrameTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        g_maps = 0;
+        g_unmaps = 0;
+    }
+};
+
+TEST(GstPlaneView, geometry) {
+    alignas(64) std::uint8_t memory[64 * 4]{};
+    GstPlaneView<guint8> plane{memory, 40, 4, 64};
+    ASSERT_EQ(plane.width(), 40U);
+    ASSERT_EQ(plane.height(), 4U);
+    ASSERT_EQ(plane.stride(), 64);
+    ASSERT_EQ(plane.padding(), 24U);
+    ASSERT_EQ(plane.paddedWidth(), 64U);
+    ASSERT_EQ(plane.row(2), memory + 128);
+
+    GstPlaneView<guint16> wide{memory, 40, 4, 64};
+    ASSERT_EQ(wide.width(), 20U);
+    ASSERT_EQ(wide.paddedWidth(), 32U);
+    ASSERT_EQ(reinterpret_cast<std::uint8_t *>(wide.row(1)), memory + 64);
+}
+
+TEST(GstPlaneView, alignment) {
+    alignas(64) std::uint8_t memory[256 * 3]{};
+    ASSERT_EQ((GstPlaneView<guint8>{memory, 200, 2, 256}.alignment()), 64U);
+    ASSERT_EQ((GstPlaneView<guint8>{memory, 200, 2, 200}.alignment()), 8U);
+    ASSERT_EQ((GstPlaneView<guint8>{memory + 4, 200, 2, 256}.alignment()), 4U);
+    ASSERT_EQ((GstPlaneView<guint8>{memory + 1, 200, 2, 256}.alignment()), 1U);
+
+    ASSERT_TRUE((GstPlaneView<guint8>{memory, 200, 2, 256}.isVectorFriendly(16)));
+    ASSERT_TRUE((GstPlaneView<guint8>{memory, 200, 2, 208}.isVectorFriendly(16)));
+    ASSERT_FALSE((GstPlaneView<guint8>{memory, 200, 2, 200}.isVectorFriendly(16)));
+    ASSERT_FALSE(
+        (GstPlaneView<guint8>{memory + 4, 200, 2, 256}.isVectorFriendly(16)));
+}
+
+TEST(GstPlaneView, last_row_has_no_padding) {
+    alignas(64) std::uint8_t memory[64 * 3]{};
+    GstPlaneView<guint8> plane{memory, 40, 3, 64};
+    ASSERT_EQ(plane.paddedRows(), 2U);
+    ASSERT_EQ(plane.paddedRowSpan(0).size(), 64U);
+    ASSERT_EQ(plane.paddedRowSpan(1).size(), 64U);
+    ASSERT_EQ(plane.paddedRowSpan(2).size(), 40U);
+    ASSERT_EQ(plane.rowSpan(2).size(), 40U);
+    ASSERT_EQ(plane.rowSpan(2).data(), memory + 128);
+
+    ASSERT_EQ((GstPlaneView<guint8>{memory, 40, 1, 64}.paddedRows()), 0U);
+    ASSERT_EQ((GstPlaneView<guint8>{memory, 40, 0, 64}.paddedRows()), 0U);
+}
+
+TEST(GstPlaneView, row_span) {
+    alignas(64) std::uint8_t memory[16 * 2]{};
+    GstPlaneView<guint8> plane{memory, 10, 2, 16};
+    guint8 value = 0;
+    for (guint8 &pixel : plane.rowSpan(1)) {
+        pixel = ++value;
+    }
+    ASSERT_EQ(memory[16], 1);
+    ASSERT_EQ(memory[25], 10);
+    ASSERT_EQ(memory[26], 0);
+}
+
+TEST_F(GstMappedVideoFrameTest, i420_planes) {
+    const GstVideoInfo info = videoInfo(I420_INFO, 320, 240, {384, 192, 192});
+    GstPtr<GstBuffer> buffer = new MemoryBuffer(info.size);
+    GstMappedVideoFrame frame{buffer, info, GST_MAP_READ};
+    ASSERT_EQ(frame.planes(), 3U);
+    ASSERT_EQ(frame.width(), 320U);
+    ASSERT_EQ(frame.height(), 240U);
+    ASSERT_EQ(frame.format(), GST_VIDEO_FORMAT_I420);
+
+    auto luma = frame.plane(0);
+    ASSERT_EQ(luma.width(), 320U);
+    ASSERT_EQ(luma.height(), 240U);
+    ASSERT_EQ(luma.padding(), 64U);
+    ASSERT_EQ(luma.alignment(), 64U);
+    for (guint index = 1; index < 3; ++index) {
+        auto chroma = frame.plane(index);
+        ASSERT_EQ(chroma.width(), 160U);
+        ASSERT_EQ(chroma.height(), 120U);
+        ASSERT_EQ(chroma.stride(), 192);
+        ASSERT_EQ(chroma.padding(), 32U);
+        ASSERT_EQ(chroma.row(0),
+                  static_cast<MemoryBuffer *>(buffer.self())->m_memory +
+                      info.offset[index]);
+    }
+}
+
+TEST_F(GstMappedVideoFrameTest, odd_size_rounds_up) {
+    const GstVideoInfo info = videoInfo(I420_INFO, 321, 241, {336, 176, 176});
+    GstPtr<GstBuffer> buffer = new MemoryBuffer(info.size);
+    GstMappedVideoFrame frame{buffer, info, GST_MAP_READ};
+    ASSERT_EQ(frame.plane(0).width(), 321U);
+    ASSERT_EQ(frame.plane(0).height(), 241U);
+    ASSERT_EQ(frame.plane(1).width(), 161U);
+    ASSERT_EQ(frame.plane(1).height(), 121U);
+    ASSERT_EQ(frame.plane(2).paddedRows(), 120U);
+}
+
+TEST_F(GstMappedVideoFrameTest, nv12_interleaved_plane) {
+    const GstVideoInfo info = videoInfo(NV12_INFO, 321, 241, {384, 384});
+    GstPtr<GstBuffer> buffer = new MemoryBuffer(info.size);
+    GstMappedVideoFrame frame{buffer, info, GST_MAP_READ};
+    ASSERT_EQ(frame.planes(), 2U);
+
+    // UV pairs: 161 of them, 2 bytes each
+    auto uv = frame.plane(1);
+    ASSERT_EQ(uv.width(), 322U);
+    ASSERT_EQ(uv.height(), 121U);
+    ASSERT_EQ(uv.padding(), 62U);
+    auto pairs = frame.plane<guint16>(1);
+    ASSERT_EQ(pairs.width(), 161U);
+    ASSERT_EQ(pairs.paddedWidth(), 192U);
+    ASSERT_EQ(pairs.paddedRowSpan(120).size(), 161U);
+}
+
+TEST_F(GstMappedVideoFrameTest, unmaps_once) {
+    const GstVideoInfo info = videoInfo(I420_INFO, 16, 16, {16, 8, 8});
+    GstPtr<GstBuffer> buffer = new MemoryBuffer(info.size);
+    {
+        GstMappedVideoFrame frame{buffer, info, GST_MAP_READ};
+        GstMappedVideoFrame moved{std::move(frame)};
+        ASSERT_EQ(g_maps, 1);
+        ASSERT_EQ(g_unmaps, 0);
+    }
+    ASSERT_EQ(g_unmaps, 1);
+}
+
+TEST_F(GstMappedVideoFrameTest, map_failure_throws) {
+    const GstVideoInfo info = videoInfo(I420_INFO, 16, 16, {16, 8, 8});
+    GstPtr<GstBuffer> small = new MemoryBuffer(info.size - 1);
+    ASSERT_THROW((GstMappedVideoFrame{small, info, GST_MAP_READ}),
+                 std::runtime_error);
+    ASSERT_THROW((GstMappedVideoFrame{GstPtr<GstBuffer>{}, info, GST_MAP_READ}),
+                 std::runtime_error);
+    ASSERT_EQ(g_unmaps, 0);
+}
+
+TEST_F(GstMappedVideoFrameTest, transform_in_place) {
+    const GstVideoInfo info = videoInfo(I420_INFO, 16, 16, {16, 8, 8});
+    GstPtr<GstBuffer> buffer = new MemoryBuffer(info.size);
+    {
+        GstMappedVideoTransform transform{buffer, info, buffer, info};
+        ASSERT_TRUE(transform.isInPlace());
+        ASSERT_EQ(&transform.input(), &transform.output());
+        ASSERT_EQ(g_lastFlags, GST_MAP_READWRITE);
+        ASSERT_EQ(g_maps, 1);
+    }
+    ASSERT_EQ(g_unmaps, 1);
+
+    // The output layout can't differ from the input one
+    const GstVideoInfo smaller = videoInfo(I420_INFO, 8, 8, {8, 4, 4});
+    ASSERT_THROW((GstMappedVideoTransform{buffer, info, buffer, smaller}),
+                 std::invalid_argument);
+    ASSERT_EQ(g_maps, 1);
+}
+
+TEST_F(GstMappedVideoFrameTest, transform_not_in_place) {
+    const GstVideoInfo info = videoInfo(I420_INFO, 16, 16, {16, 8, 8});
+    GstPtr<GstBuffer> input = new MemoryBuffer(info.size);
+    GstPtr<GstBuffer> output = new MemoryBuffer(info.size);
+    {
+        GstMappedVideoTransform transform{input, info, output, info};
+        ASSERT_FALSE(transform.isInPlace());
+        ASSERT_EQ(g_lastFlags, GST_MAP_WRITE);
+        ASSERT_EQ(transform.output().plane(0).row(0),
+                  static_cast<MemoryBuffer *>(output.self())->m_memory);
+        ASSERT_EQ(g_maps, 2);
+    }
+    ASSERT_EQ(g_unmaps, 2);
+
+    // The input is unmapped if the output can't be mapped
+    GstPtr<GstBuffer> small = new MemoryBuffer(info.size - 1);
+    ASSERT_THROW((GstMappedVideoTransform{input, info, small, info}),
+                 std::runtime_error);
+    ASSERT_EQ(g_unmaps, 3);
+}
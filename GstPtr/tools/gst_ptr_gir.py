@@ -0,0 +1,518 @@
+#!/usr/bin/env python3
+#
+# Generates GstPtr<> interface mappings and transfer-aware wrappers from
+# GObject-Introspection (.gir) files.
+# (C) 2022 Nacho Garcia <nacho.garglez@gmail.com>
+# Licensed under the MIT License. See LICENSE file for details.
+#
+"""
+Reads .gir files and writes a header with:
+
+- A detail::GetInterface<> specialization for every GObject class, interface,
+  GstMiniObject and boxed type of the given namespaces (and for the ancestors
+  they need), with the right ref/unref/sink functions and GType. Types already
+  mapped by the GstPtr headers are not mapped again; their header is included.
+- In namespace gir, an inline wrapper for every function whose parameters and
+  return value can be expressed with GstPtr:
+
+    [transfer full] return      -> GstPtr<Type>          (no extra ref)
+    [transfer floating] return  -> GstPtr<Type>, sunk
+    [transfer none] return      -> GstPtrView<Type>      (no ref at all)
+    [transfer full] parameter   -> GstPtr<Type> &&       (transferFull())
+    [transfer none] parameter   -> GstPtrView<Type>      (self())
+
+  Functions with out/inout parameters, arrays, callbacks, varargs or GError
+  are skipped: call the C function for those.
+
+Usage:
+  gst_ptr_gir.py --output gst_ptr_gir_gstbase.h [--gir-dir DIR]... GstBase-1.0
+
+GIRs are given by path or by name (searched in the --gir-dir directories).
+Included namespaces are loaded from the same directories when found.
+"""
+
+import argparse
+import glob
+import os
+import re
+import sys
+import xml.etree.ElementTree as ElementTree
+
+CORE = "{http://www.gtk.org/introspection/core/1.0}"
+C = "{http://www.gtk.org/introspection/c/1.0}"
+GLIB = "{http://www.gtk.org/introspection/glib/1.0}"
+
+# GObject base types, which are not described by any .gir we load
+GOBJECT = "GObject.Object"
+INITIALLY_UNOWNED = "GObject.InitiallyUnowned"
+MINI_OBJECT = "Gst.MiniObject"
+
+# Functions returning new objects, besides <constructor>s
+CONSTRUCTOR_NAME = re.compile(r"_(new|make)(_|$)")
+
+# GstPtr<> already calls these
+MEMORY_FUNCTIONS = {"ref", "unref", "ref_sink", "free"}
+
+CPP_KEYWORDS = {
+    "and", "auto", "bool", "break", "case", "catch", "char", "class", "const",
+    "continue", "default", "delete", "do", "double", "else", "enum",
+    "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+    "if", "inline", "int", "long", "namespace", "new", "not", "operator", "or",
+    "private", "protected", "public", "register", "return", "short", "signed",
+    "sizeof", "static", "struct", "switch", "template", "this", "throw",
+    "true", "try", "typedef", "typename", "union", "unsigned", "using",
+    "virtual", "void", "volatile", "while", "xor",
+}
+
+
+class GirType:
+    """A type that can be mapped for GstPtr<>"""
+
+    def __init__(self, qname, ctype, kind, get_type=None, parent=None):
+        self.qname = qname
+        self.ctype = ctype
+        # class, interface, miniobject, refcounted, boxed or mapped
+        self.kind = kind
+        self.get_type = get_type
+        self.parent = parent
+        self.ref_func = None
+        self.unref_func = None
+        self.element = None
+        self.target = False
+        # For types mapped by a GstPtr header
+        self.header = None
+        self.interface_base = None
+
+
+class Registry:
+    def __init__(self, gir_dirs):
+        self.gir_dirs = gir_dirs
+        self.types = {}
+        self.by_ctype = {}
+        self.loaded = set()
+        self.namespaces = []
+        self.c_includes = []
+
+    # ---------------------------------------------------------------
+    # Loading
+    # ---------------------------------------------------------------
+
+    def find_gir(self, name):
+        if os.path.isfile(name):
+            return name
+        for directory in self.gir_dirs:
+            candidate = os.path.join(directory, name + ".gir")
+            if os.path.isfile(candidate):
+                return candidate
+        return None
+
+    def load(self, gir, target):
+        path = self.find_gir(gir)
+        if path is None:
+            if target:
+                sys.exit("gst_ptr_gir: cannot find " + gir)
+            print("gst_ptr_gir: {} not found, its types are resolved by "
+                  "name".format(gir), file=sys.stderr)
+            return
+        path = os.path.realpath(path)
+        if path in self.loaded:
+            return
+        self.loaded.add(path)
+
+        root = ElementTree.parse(path).getroot()
+        for include in root.findall(CORE + "include"):
+            self.load("{}-{}".format(include.get("name"), include.get("version")),
+                      False)
+        for namespace in root.findall(CORE + "namespace"):
+            self.load_namespace(namespace, target)
+        if target:
+            self.c_includes += [include.get("name")
+                                for include in root.findall(C + "include")]
+
+    def load_namespace(self, namespace, target):
+        name = namespace.get("name")
+        if target:
+            self.namespaces.append(namespace)
+
+        for element in namespace.findall(CORE + "class"):
+            if element.get(GLIB + "get-type") is None:
+                continue
+            gir_type = GirType(self.qualify(name, element.get("name")),
+                               element.get(C + "type"), "class",
+                               element.get(GLIB + "get-type"),
+                               self.qualify(name, element.get("parent")))
+            gir_type.ref_func = element.get(GLIB + "ref-func")
+            gir_type.unref_func = element.get(GLIB + "unref-func")
+            self.add(gir_type, element, target)
+
+        for element in namespace.findall(CORE + "interface"):
+            if element.get(GLIB + "get-type") is None:
+                continue
+            self.add(GirType(self.qualify(name, element.get("name")),
+                             element.get(C + "type"), "interface",
+                             element.get(GLIB + "get-type")), element, target)
+
+        for element in namespace.findall(CORE + "record"):
+            if (element.get(GLIB + "get-type") is None or
+                    element.get(GLIB + "is-gtype-struct-for") is not None or
+                    element.get(C + "type") is None):
+                continue
+            qname = self.qualify(name, element.get("name"))
+            if qname == MINI_OBJECT:
+                continue
+            gir_type = GirType(qname, element.get(C + "type"), "boxed",
+                               element.get(GLIB + "get-type"))
+            first_field = element.find(CORE + "field")
+            field_type = (first_field.find(CORE + "type")
+                          if first_field is not None else None)
+            if field_type is not None and field_type.get("name") is not None:
+                parent = self.qualify(name, field_type.get("name"))
+                if parent == MINI_OBJECT or self.is_mini_object(parent):
+                    gir_type.kind = "miniobject"
+                    gir_type.parent = parent
+            if gir_type.kind == "boxed":
+                methods = {method.get("name"): method.get(C + "identifier")
+                           for method in element.findall(CORE + "method")}
+                if "ref" in methods and "unref" in methods:
+                    gir_type.kind = "refcounted"
+                    gir_type.ref_func = methods["ref"]
+                    gir_type.unref_func = methods["unref"]
+            self.add(gir_type, element, target)
+
+    def load_mapped(self, headers):
+        """Types mapped by GstPtr headers: GetInterface<> and I<Type> bases"""
+        mapping = re.compile(r"GST_PTR_MAP_INTERFACE_WITH_TYPE\(\s*(\w+)\s*,")
+        interface = re.compile(r"struct\s+I(\w+)\s*:\s*I(\w+)\s*\{")
+        bases = {}
+        for header in headers:
+            with open(header, encoding="utf-8") as source:
+                text = source.read()
+            for ctype, base in interface.findall(text):
+                bases[ctype] = base
+            for ctype in mapping.findall(text):
+                if ctype in self.by_ctype and self.by_ctype[ctype].header:
+                    continue
+                gir_type = GirType(None, ctype, "mapped")
+                gir_type.header = os.path.basename(header)
+                self.by_ctype[ctype] = gir_type
+        for ctype, gir_type in self.by_ctype.items():
+            if gir_type.kind == "mapped":
+                gir_type.interface_base = bases.get(ctype)
+
+    def add(self, gir_type, element, target):
+        gir_type.element = element
+        gir_type.target = target
+        self.types[gir_type.qname] = gir_type
+        mapped = self.by_ctype.get(gir_type.ctype)
+        if mapped is not None and mapped.header is not None:
+            # Keep the header mapping, but learn its place in the hierarchy
+            mapped.qname = gir_type.qname
+            mapped.parent = gir_type.parent
+            mapped.element = element
+            mapped.target = target
+            self.types[gir_type.qname] = mapped
+            return
+        self.by_ctype[gir_type.ctype] = gir_type
+
+    @staticmethod
+    def qualify(namespace, name):
+        if name is None or "." in name:
+            return name
+        return namespace + "." + name
+
+    def is_mini_object(self, qname):
+        gir_type = self.types.get(qname)
+        return gir_type is not None and gir_type.kind == "miniobject"
+
+    # ---------------------------------------------------------------
+    # Queries
+    # ---------------------------------------------------------------
+
+    def resolve(self, qname):
+        """GirType of a qualified name, also for namespaces not loaded"""
+        if qname in self.types:
+            return self.types[qname]
+        if qname is None or "." not in qname:
+            return None
+        namespace, name = qname.split(".", 1)
+        return self.by_ctype.get(namespace + name)
+
+    def is_floating(self, gir_type):
+        seen = set()
+        while gir_type is not None and gir_type.qname not in seen:
+            seen.add(gir_type.qname)
+            if gir_type.parent == INITIALLY_UNOWNED:
+                return True
+            if gir_type.kind == "mapped" and gir_type.parent is None:
+                return self.is_mapped_floating(gir_type.ctype)
+            gir_type = self.resolve(gir_type.parent)
+        return False
+
+    def is_mapped_floating(self, ctype):
+        # Without .gir data, GstObject descendants are the floating ones
+        while ctype is not None:
+            if ctype == "GstObject":
+                return True
+            mapped = self.by_ctype.get(ctype)
+            ctype = mapped.interface_base if mapped is not None else None
+        return False
+
+
+class Generator:
+    def __init__(self, registry):
+        self.registry = registry
+        self.emitted = set()
+        self.mappings = []
+        self.headers = set()
+        self.wrappers = []
+        self.wrapped = set()
+
+    # ---------------------------------------------------------------
+    # Interface mappings
+    # ---------------------------------------------------------------
+
+    def interface_of(self, gir_type):
+        """Name of the I<Type> struct, emitting its mapping if needed"""
+        if gir_type.kind == "mapped":
+            self.headers.add(gir_type.header)
+            return "I" + gir_type.ctype
+        if gir_type.ctype not in self.emitted:
+            self.emitted.add(gir_type.ctype)
+            self.emit_mapping(gir_type)
+        return "I" + gir_type.ctype
+
+    def base_interface(self, gir_type):
+        if gir_type.kind == "miniobject":
+            parent = self.registry.resolve(gir_type.parent)
+            return self.interface_of(parent) if parent else "IGstMiniObject"
+        if gir_type.parent in (None, GOBJECT, INITIALLY_UNOWNED):
+            return "IGObject"
+        parent = self.registry.resolve(gir_type.parent)
+        if parent is None:
+            print("gst_ptr_gir: unknown parent {} of {}, using GObject".format(
+                gir_type.parent, gir_type.ctype), file=sys.stderr)
+            return "IGObject"
+        return self.interface_of(parent)
+
+    def emit_mapping(self, gir_type):
+        name = "I" + gir_type.ctype
+        if gir_type.kind in ("class", "interface", "miniobject") and not (
+                gir_type.kind == "class" and gir_type.ref_func):
+            body = "struct {} : {} {{}};".format(name,
+                                                 self.base_interface(gir_type))
+        elif gir_type.ref_func and gir_type.unref_func:
+            body = ("struct {name} {{\n"
+                    "  template <typename T> static void ref(T *ptr) noexcept {{\n"
+                    "    {ref}(({ctype} *)ptr);\n"
+                    "  }}\n"
+                    "  template <typename T> static void unref(T *ptr) noexcept {{\n"
+                    "    {unref}(({ctype} *)ptr);\n"
+                    "  }}\n"
+                    "}};").format(name=name, ref=gir_type.ref_func,
+                                  unref=gir_type.unref_func,
+                                  ctype=gir_type.ctype)
+        else:
+            # Boxed: copying is a real copy, so GstPtr<> can only be moved
+            body = ("struct {name} {{\n"
+                    "  template <typename T> static void unref(T *ptr) noexcept {{\n"
+                    "    g_boxed_free({get_type}(), ptr);\n"
+                    "  }}\n"
+                    "}};").format(name=name, get_type=gir_type.get_type)
+        self.mappings.append(
+            "{}\nGST_PTR_MAP_INTERFACE_WITH_TYPE({}, {}())".format(
+                body, gir_type.ctype, gir_type.get_type))
+
+    # ---------------------------------------------------------------
+    # Wrappers
+    # ---------------------------------------------------------------
+
+    def mapped_pointer(self, type_element):
+        """GirType if \\p type_element is a single pointer to a mapped type"""
+        ctype = type_element.get(C + "type")
+        if ctype is None or ctype.count("*") != 1:
+            return None, False
+        bare = ctype.replace("const ", "").replace("*", "").strip()
+        gir_type = self.registry.by_ctype.get(bare)
+        if gir_type is None:
+            return None, False
+        self.interface_of(gir_type)
+        return gir_type, ctype.strip().startswith("const")
+
+    @staticmethod
+    def parameter_name(name):
+        return name + "_" if name in CPP_KEYWORDS else name
+
+    def wrap(self, function, is_constructor):
+        identifier = function.get(C + "identifier")
+        if (identifier is None or identifier in self.wrapped or
+                function.get("name") in MEMORY_FUNCTIONS or
+                function.get("introspectable") == "0" or
+                function.get("deprecated") == "1" or
+                function.get("throws") == "1" or
+                function.get("moved-to") is not None):
+            return
+
+        parameters = []
+        arguments = []
+        parameters_element = function.find(CORE + "parameters")
+        for parameter in (list(parameters_element)
+                          if parameters_element is not None else []):
+            if parameter.tag == CORE + "varargs":
+                return
+            type_element = parameter.find(CORE + "type")
+            if (type_element is None or
+                    parameter.find(CORE + "varargs") is not None or
+                    parameter.get("direction", "in") != "in" or
+                    parameter.get("scope") is not None):
+                return
+            name = self.parameter_name(parameter.get("name"))
+            transfer = parameter.get("transfer-ownership", "none")
+            gir_type, _ = self.mapped_pointer(type_element)
+            if gir_type is None:
+                ctype = type_element.get(C + "type")
+                if ctype is None:
+                    return
+                parameters.append("{} {}".format(ctype, name))
+                arguments.append(name)
+            elif transfer == "full":
+                parameters.append("GstPtr<{}> &&{}".format(gir_type.ctype, name))
+                arguments.append(name + ".transferFull()")
+            elif transfer == "none":
+                parameters.append("GstPtrView<{}> {}".format(gir_type.ctype,
+                                                             name))
+                arguments.append(name + ".self()")
+            else:
+                return
+
+        call = "::{}({})".format(identifier, ", ".join(arguments))
+        return_element = function.find(CORE + "return-value")
+        return_type = (return_element.find(CORE + "type")
+                       if return_element is not None else None)
+        if return_type is None:
+            return
+        gir_type, is_const = self.mapped_pointer(return_type)
+        if gir_type is None:
+            ctype = return_type.get(C + "type")
+            if ctype is None and return_type.get("name") == "none":
+                ctype = "void"
+            if ctype is None:
+                return
+            signature = "inline {} {}".format(ctype, identifier)
+            body = ("{};" if ctype == "void" else "return {};").format(call)
+        else:
+            transfer = return_element.get("transfer-ownership", "none")
+            target = gir_type.ctype
+            if is_const:
+                call = "const_cast<{} *>({})".format(target, call)
+            # g-ir-scanner writes (transfer floating) as "none". Sinking is
+            # right either way: a non floating object gets the ref we need.
+            floating = transfer == "floating" or (
+                transfer == "none" and self.registry.is_floating(gir_type) and
+                (is_constructor or CONSTRUCTOR_NAME.search(identifier)))
+            if floating:
+                signature = "[[nodiscard]] inline GstPtr<{}> {}".format(
+                    target, identifier)
+                body = ("GstPtr<{0}> result{{{1}}};\n"
+                        "  result.sink();\n"
+                        "  return result;").format(target, call)
+            elif transfer == "full":
+                signature = "[[nodiscard]] inline GstPtr<{}> {}".format(
+                    target, identifier)
+                body = "return GstPtr<{}>{{{}}};".format(target, call)
+            elif transfer == "none":
+                signature = "[[nodiscard]] inline GstPtrView<{}> {}".format(
+                    target, identifier)
+                body = "return GstPtrView<{}>{{{}}};".format(target, call)
+            else:
+                return
+
+        self.wrapped.add(identifier)
+        self.wrappers.append("{}({}) {{\n  {}\n}}".format(
+            signature, ", ".join(parameters), body))
+
+    def generate(self):
+        registry = self.registry
+        for gir_type in list(registry.types.values()):
+            if gir_type.target:
+                self.interface_of(gir_type)
+
+        for namespace in registry.namespaces:
+            for function in namespace.findall(CORE + "function"):
+                self.wrap(function, False)
+            for kind in ("class", "interface", "record"):
+                for element in namespace.findall(CORE + kind):
+                    for constructor in element.findall(CORE + "constructor"):
+                        self.wrap(constructor, True)
+                    for tag in ("method", "function"):
+                        for function in element.findall(CORE + tag):
+                            self.wrap(function, False)
+
+    def write(self, output, sources):
+        lines = [
+            "/*",
+            " *  GstPtr<> mappings and wrappers generated by gst_ptr_gir.py",
+            " *  from " + ", ".join(sources) + ". Do not edit.",
+            " *",
+            " *  This needs C++17",
+            " *",
+            " */",
+            "",
+            "#pragma once",
+            "",
+        ]
+        for include in self.registry.c_includes:
+            lines += ["#if __has_include(<{0}>)".format(include),
+                      "#include <{0}>".format(include), "#endif"]
+        lines += ["", '#include "gst_ptr.h"']
+        lines += ['#include "{}"'.format(header)
+                  for header in sorted(self.headers) if header != "gst_ptr.h"]
+        lines += ["", "namespace detail {", ""]
+        for mapping in self.mappings:
+            lines += [mapping, ""]
+        lines += ["} // namespace detail", "", "namespace gir {", ""]
+        for wrapper in self.wrappers:
+            lines += [wrapper, ""]
+        lines += ["} // namespace gir", ""]
+
+        text = "\n".join(lines)
+        # Only touch the output when it changes, to avoid needless rebuilds
+        if os.path.isfile(output):
+            with open(output, encoding="utf-8") as existing:
+                if existing.read() == text:
+                    return
+        os.makedirs(os.path.dirname(os.path.abspath(output)), exist_ok=True)
+        with open(output, "w", encoding="utf-8") as generated:
+            generated.write(text)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(
+        description="Generate GstPtr<> mappings and wrappers from .gir files")
+    parser.add_argument("girs", nargs="+", help=".gir files or names")
+    parser.add_argument("--output", required=True, help="header to write")
+    parser.add_argument("--gir-dir", action="append", default=[],
+                        help="where to look for .gir files (repeatable)")
+    parser.add_argument("--mapped", action="append", default=None,
+                        help="GstPtr headers whose mappings are reused "
+                             "(default: the gst_ptr*.h next to this tool)")
+    arguments = parser.parse_args()
+
+    gir_dirs = arguments.gir_dir or ["/usr/share/gir-1.0"]
+    mapped = arguments.mapped
+    if mapped is None:
+        mapped = sorted(glob.glob(os.path.join(here, "..", "gst_ptr*.h")))
+
+    registry = Registry(gir_dirs)
+    registry.load_mapped(mapped)
+    for gir in arguments.girs:
+        registry.load(gir, True)
+
+    generator = Generator(registry)
+    generator.generate()
+    generator.write(arguments.output,
+                    [os.path.basename(gir) for gir in arguments.girs])
+
+
+if __name__ == "__main__":
+    main()
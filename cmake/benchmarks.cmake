@@ -0,0 +1,26 @@
+#
+# Benchmark module
+#
+# Authors: Manel Jimeno <manel.jimeno@gmail.com>
+#
+# License: https://www.gnu.org/licenses/lgpl-3.0.html LGPL version 3 or higher
+#
+
+# Create a benchmark target. Benchmarks provide their own main(), since most of
+# them need to call gst_init() first.
+function(add_cpp_benchmark)
+    set(oneValueArgs TARGET)
+    set(multiValueArgs LIBRARIES)
+    cmake_parse_arguments(CONFIG "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+    config_target(
+        TARGET
+        ${CONFIG_TARGET}
+        SOURCES
+        ${CONFIG_TARGET}.cpp
+        LIBRARIES
+        ${CONFIG_LIBRARIES}
+        benchmark::benchmark
+        CPP)
+    set_target_properties(${CONFIG_TARGET} PROPERTIES FOLDER "benchmark")
+endfunction()
@@ -0,0 +1,64 @@
+#
+# GstPtr<> mappings and wrappers generated from GObject-Introspection files
+#
+# Authors: Manel Jimeno <manel.jimeno@gmail.com>
+#
+# License: https://www.gnu.org/licenses/lgpl-3.0.html LGPL version 3 or higher
+#
+
+set(GST_PTR_GIR_SCRIPT "${CMAKE_CURRENT_LIST_DIR}/../GstPtr/tools/gst_ptr_gir.py")
+set(GST_PTR_HEADERS_DIR "${CMAKE_CURRENT_LIST_DIR}/../GstPtr")
+
+# Create an interface target providing a header generated from .gir files.
+#
+#   gst_ptr_generate_gir(TARGET gst_ptr_gstbase OUTPUT gst_ptr_gir_gstbase.h
+#                        GIRS GstBase-1.0 [GIR_DIRS /usr/share/gir-1.0])
+#
+# GIRS are .gir paths or names. GIR_DIRS defaults to the girdir of
+# gobject-introspection-1.0, or /usr/share/gir-1.0.
+function(gst_ptr_generate_gir)
+    set(oneValueArgs TARGET OUTPUT)
+    set(multiValueArgs GIRS GIR_DIRS)
+    cmake_parse_arguments(CONFIG "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+    if(NOT CONFIG_GIR_DIRS)
+        find_package(PkgConfig QUIET)
+        if(PkgConfig_FOUND)
+            pkg_get_variable(GIR_DIR gobject-introspection-1.0 girdir)
+        endif()
+        if(GIR_DIR)
+            set(CONFIG_GIR_DIRS "${GIR_DIR}")
+        else()
+            set(CONFIG_GIR_DIRS "/usr/share/gir-1.0")
+        endif()
+    endif()
+
+    set(GIR_DIR_ARGS)
+    foreach(DIR IN LISTS CONFIG_GIR_DIRS)
+        list(APPEND GIR_DIR_ARGS --gir-dir "${DIR}")
+    endforeach()
+
+    set(GIR_FILES)
+    foreach(GIR IN LISTS CONFIG_GIRS)
+        if(EXISTS "${GIR}")
+            list(APPEND GIR_FILES "${GIR}")
+        endif()
+    endforeach()
+
+    file(GLOB MAPPED_HEADERS "${GST_PTR_HEADERS_DIR}/gst_ptr*.h")
+    set(OUTPUT_DIR "${CMAKE_CURRENT_BINARY_DIR}/${CONFIG_TARGET}")
+    set(OUTPUT "${OUTPUT_DIR}/${CONFIG_OUTPUT}")
+
+    message(STATUS "Generating ${CONFIG_OUTPUT} from ${CONFIG_GIRS}")
+    add_custom_command(
+        OUTPUT "${OUTPUT}"
+        COMMAND "${Python3_EXECUTABLE}" "${GST_PTR_GIR_SCRIPT}" --output "${OUTPUT}" ${GIR_DIR_ARGS} ${CONFIG_GIRS}
+        DEPENDS "${GST_PTR_GIR_SCRIPT}" ${GIR_FILES} ${MAPPED_HEADERS}
+        COMMENT "Generating ${CONFIG_OUTPUT}"
+        VERBATIM)
+    add_custom_target(${CONFIG_TARGET}_generate DEPENDS "${OUTPUT}")
+
+    add_library(${CONFIG_TARGET} INTERFACE)
+    add_dependencies(${CONFIG_TARGET} ${CONFIG_TARGET}_generate)
+    target_include_directories(${CONFIG_TARGET} INTERFACE "${OUTPUT_DIR}" "${GST_PTR_HEADERS_DIR}")
+endfunction()